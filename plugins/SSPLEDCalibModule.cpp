@@ -116,8 +116,10 @@ SSPLEDCalibModule::do_stop(const data_t& args)
 }
 
 void
-SSPLEDCalibModule::get_info(opmonlib::InfoCollector& /*ci*/, int /*level*/)
-{}
+SSPLEDCalibModule::get_info(opmonlib::InfoCollector& ci, int level)
+{
+  m_card_wrapper->get_info(ci, level);
+}
 
 } // namespace sspmodules
 } // namespace dunedaq
@@ -10,9 +10,12 @@
 
 // From Module
 #include "SSPLEDCalibWrapper.hpp"
+#include "sspmodules/sspledcalibmoduleinfo/InfoNljs.hpp"
 
 // From STD
 #include <chrono>
+#include <cstdint>
+#include <exception>
 #include <iomanip>
 #include <string>
 #include <utility>
@@ -84,7 +87,7 @@ SSPLEDCalibWrapper::configure(const data_t& args)
   m_pulse_bias_percent_270nm = m_cfg.pulse_bias_percent_270nm;
   m_pulse_bias_percent_367nm = m_cfg.pulse_bias_percent_367nm;
   
-  if (m_cfg.board_ip == "default") {
+  if (m_cfg.interface_type == dunedaq::fddetdataformats::ssp::kEthernet && m_cfg.board_ip == "default") {
     TLOG() << "SSPLEDCalibWrapper::configure: This Board IP value in the Conf is set to: default" << std::endl
            << "As we currently only deal with SSPs on ethernet, this means that either the Board IP was " << std::endl
            << "NOT set, or the args.get<Conf> call failed to find parameters." << std::endl;
@@ -111,10 +114,26 @@ SSPLEDCalibWrapper::configure(const data_t& args)
 
   m_device_interface->SetPartitionNumber(m_partition_number);
   m_device_interface->SetTimingAddress(m_timing_address);
+  m_device_interface->SetAsyncReceive(m_cfg.async_receive);
+  m_device_interface->SetNChannels(m_number_channels);
+  m_device_interface->SetPacketBufferLimits(m_cfg.packet_buffer_max_bytes, m_cfg.packet_buffer_max_span);
+  m_device_interface->SetMaxPendingTriggers(m_cfg.max_pending_triggers);
+
+  PollStrategy::Settings poll_settings;
+  PollStrategy::ParseMode(m_cfg.poll_strategy, poll_settings.mode);
+  poll_settings.spinInUs = m_cfg.poll_spin_us;
+  poll_settings.yieldInUs = m_cfg.poll_yield_us;
+  poll_settings.maxSleepInUs = m_cfg.poll_max_sleep_us;
+  m_device_interface->SetPollStrategy(poll_settings);
   m_module_id = m_cfg.module_id;
   m_device_interface->ConfigureLEDCalib(args); //This sets up the ethernet interface and make sure that the pdts is synched
   m_device_interface->SetRegisterByName("module_id", m_module_id);
-  m_device_interface->SetRegisterByName("eventDataInterfaceSelect", m_cfg.interface_type);
+  // An emulated board stands in for an Ethernet one, so select that data interface for it
+  if (m_cfg.interface_type == dunedaq::fddetdataformats::ssp::kEmulated) {
+    m_device_interface->SetRegisterByName("eventDataInterfaceSelect", dunedaq::fddetdataformats::ssp::kEthernet);
+  } else {
+    m_device_interface->SetRegisterByName("eventDataInterfaceSelect", m_cfg.interface_type);
+  }
 
   if ( m_cfg.pulse_mode == "single") {
     m_single_pulse = true;
@@ -181,44 +200,48 @@ SSPLEDCalibWrapper::start(const data_t& args)
   unsigned int pulse_bias_setting_270nm = (4095 * m_pulse_bias_percent_270nm)/100;
   unsigned int pulse_bias_setting_367nm = (4095 * m_pulse_bias_percent_367nm)/100;
   
-  for (unsigned int counter = 0; counter < m_number_channels ; counter++) {
-    unsigned int bias_regAddress =  base_bias_regAddress + 0x4*(counter);  //0x40000340 - 0x4000036C
-    unsigned int bias_regVal = 0x00040000;
-    unsigned int timing_regAddress =  base_timing_regAddress + 0x4*(counter); //0x80003C0 - 0x800003EC
-    unsigned int timing_regVal = 0x0; //the highest byte sets 8 (pdts trigger) + 1 (953.5 Hz) for burst mode, but 8 (pdts trigger) + 7 (single shot) for single
-    if (m_single_pulse) {
-      timing_regVal = 0xF0000000;
-    } else if (m_burst_mode) {
-      timing_regVal = 0x90000000;
-    }
+  {
+    DeviceInterface::WriteBatch batch(*m_device_interface); // bias and timing registers go out as two array writes
+    for (unsigned int counter = 0; counter < m_number_channels ; counter++) {
+      unsigned int bias_regAddress =  base_bias_regAddress + 0x4*(counter);  //0x40000340 - 0x4000036C
+      unsigned int bias_regVal = 0x00040000;
+      unsigned int timing_regAddress =  base_timing_regAddress + 0x4*(counter); //0x80003C0 - 0x800003EC
+      unsigned int timing_regVal = 0x0; //the highest byte sets 8 (pdts trigger) + 1 (953.5 Hz) for burst mode, but 8 (pdts trigger) + 7 (single shot) for single
+      if (m_single_pulse) {
+        timing_regVal = 0xF0000000;
+      } else if (m_burst_mode) {
+        timing_regVal = 0x90000000;
+      }
       
-    TLOG(TLVL_FULL_DEBUG) << "Channel map is 0x" << std::hex << m_channel_mask << " and the comparison is 0x" << (1 << counter ) << std::endl;
-    if ( (m_channel_mask & ( (unsigned int)1 << counter)) == ((unsigned int)1 << counter) ) {      
-      if ( counter < 6) {
-	bias_regVal = bias_regVal + pulse_bias_setting_270nm;
+      TLOG(TLVL_FULL_DEBUG) << "Channel map is 0x" << std::hex << m_channel_mask << " and the comparison is 0x" << (1 << counter ) << std::endl;
+      if ( (m_channel_mask & ( (unsigned int)1 << counter)) == ((unsigned int)1 << counter) ) {      
+        if ( counter < 6) {
+	  bias_regVal = bias_regVal + pulse_bias_setting_270nm;
+        } else {
+	  bias_regVal = bias_regVal + pulse_bias_setting_367nm;
+        }
+        timing_regVal = timing_regVal + m_pulse1_width_ticks;
+        timing_regVal = timing_regVal + (m_pulse2_width_ticks << 8);
+        timing_regVal = timing_regVal + (m_double_pulse_delay_ticks << 16);
+        TLOG(TLVL_FULL_DEBUG) << "Will turn on " << std::dec << counter << " channel at bias register 0x" << std::hex << bias_regAddress << " with bias value 0x" << bias_regVal << std::endl;
+        TLOG(TLVL_FULL_DEBUG) << " and set the width regsiter 0x" << std::hex << timing_regAddress << " to value of 0x" << timing_regVal << std::dec << std::endl;
+        m_device_interface->SetRegister(bias_regAddress, bias_regVal); //BIAS_DAC_CONFIG_N
+        if ( (counter == 7) && ! ( (m_channel_mask & ( (unsigned int)1 << counter)) == ((unsigned int)1 << (counter-1) ) ) )  {
+	  //this is a really convoluted situation where for the very specific 12 channel board that arrived at CERN in June 2022
+	  //the bias for channel 7 was not working and so the bias is taken from channel 6
+	  //which means that if channel 7 is to be turned on while channel 6 is masked off
+	  //you still have to bias channel 6 in order for the led on channel 7 to emmit light
+	  m_device_interface->SetRegister((bias_regAddress - 0x4), bias_regVal); //BIAS_DAC_CONFIG_N
+        }
+	
+        m_device_interface->SetRegister(timing_regAddress, timing_regVal); //cal_CONFIG_N
       } else {
-	bias_regVal = bias_regVal + pulse_bias_setting_367nm;
-      }
-      timing_regVal = timing_regVal + m_pulse1_width_ticks;
-      timing_regVal = timing_regVal + (m_pulse2_width_ticks << 8);
-      timing_regVal = timing_regVal + (m_double_pulse_delay_ticks << 16);
-      TLOG(TLVL_FULL_DEBUG) << "Will turn on " << std::dec << counter << " channel at bias register 0x" << std::hex << bias_regAddress << " with bias value 0x" << bias_regVal << std::endl;
-      TLOG(TLVL_FULL_DEBUG) << " and set the width regsiter 0x" << std::hex << timing_regAddress << " to value of 0x" << timing_regVal << std::dec << std::endl;
-      m_device_interface->SetRegister(bias_regAddress, bias_regVal); //BIAS_DAC_CONFIG_N
-      if ( (counter == 7) && ! ( (m_channel_mask & ( (unsigned int)1 << counter)) == ((unsigned int)1 << (counter-1) ) ) )  {
-	//this is a really convoluted situation where for the very specific 12 channel board that arrived at CERN in June 2022
-	//the bias for channel 7 was not working and so the bias is taken from channel 6
-	//which means that if channel 7 is to be turned on while channel 6 is masked off
-	//you still have to bias channel 6 in order for the led on channel 7 to emmit light
-	m_device_interface->SetRegister((bias_regAddress - 0x4), bias_regVal); //BIAS_DAC_CONFIG_N
+        TLOG(TLVL_FULL_DEBUG) << "Will turn off channel " << std::dec << counter << " at timing register 0x" << std::hex << timing_regAddress << std::dec << std::endl;
+        m_device_interface->SetRegister(bias_regAddress, bias_regVal); //BIAS_DAC_CONFIG_N
+        m_device_interface->SetRegister(timing_regAddress, timing_regVal); //cal_CONFIG_N
       }
-	
-      m_device_interface->SetRegister(timing_regAddress, timing_regVal); //cal_CONFIG_N
-    } else {
-      TLOG(TLVL_FULL_DEBUG) << "Will turn off channel " << std::dec << counter << " at timing register 0x" << std::hex << timing_regAddress << std::dec << std::endl;
-      m_device_interface->SetRegister(bias_regAddress, bias_regVal); //BIAS_DAC_CONFIG_N
-      m_device_interface->SetRegister(timing_regAddress, timing_regVal); //cal_CONFIG_N
     }
+    batch.Commit();
   }
 
   m_device_interface->SetRegister(0x40000300, 0x1); //writing 0x1 to this register applies the bias voltage settings
@@ -236,11 +259,15 @@ SSPLEDCalibWrapper::stop(const data_t& /*args*/)
     TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "The run_marker says that SSPLEDCalibWrapper card " << m_board_id << " is already stopped, but stopping anyways...";
   }
 
-  for (unsigned int counter = 0; counter < 5; counter++) { //switch this to 12 for a 12 channel SSP
-    unsigned int bias_regAddress =  0x4000035C + 0x4*(counter);
-    unsigned int timing_regAddress =  0x800003DC + 0x4*(counter);
-    m_device_interface->SetRegister(bias_regAddress, 0x00040000); //BIAS_DAC_CONFIG_N
-    m_device_interface->SetRegister(timing_regAddress, 0x00000000); //cal_CONFIG_N
+  {
+    DeviceInterface::WriteBatch batch(*m_device_interface);
+    for (unsigned int counter = 0; counter < 5; counter++) { //switch this to 12 for a 12 channel SSP
+      unsigned int bias_regAddress =  0x4000035C + 0x4*(counter);
+      unsigned int timing_regAddress =  0x800003DC + 0x4*(counter);
+      m_device_interface->SetRegister(bias_regAddress, 0x00040000); //BIAS_DAC_CONFIG_N
+      m_device_interface->SetRegister(timing_regAddress, 0x00000000); //cal_CONFIG_N
+    }
+    batch.Commit();
   }
 
   m_device_interface->SetRegister(0x40000300, 0x1); //writing 0x1 to this register applies the bias voltage settings
@@ -249,28 +276,90 @@ SSPLEDCalibWrapper::stop(const data_t& /*args*/)
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "Stop pulsing SSPLEDCalibWrapper of card " << m_board_id << " complete.";
 }
 
+void
+SSPLEDCalibWrapper::get_info(opmonlib::InfoCollector& ci, int /*level*/)
+{
+  if (!m_device_interface || !m_device_interface->GetDevice()) {
+    return;
+  }
+  const DeviceStats& stats = m_device_interface->GetDevice()->Stats();
+  // Each call is counted under one operation only, so these do not overlap
+  DeviceStats::Summary reads = stats.Summarize(
+    { DeviceStats::kRead, DeviceStats::kReadMask, DeviceStats::kReadForced, DeviceStats::kArrayRead });
+  DeviceStats::Summary writes = stats.Summarize({ DeviceStats::kWrite,
+                                                  DeviceStats::kWriteMask,
+                                                  DeviceStats::kSet,
+                                                  DeviceStats::kClear,
+                                                  DeviceStats::kArrayWrite,
+                                                  DeviceStats::kWriteList });
+  DeviceStats::Summary receives = stats.Summarize({ DeviceStats::kReceive, DeviceStats::kReceiveV });
+
+  sspledcalibmoduleinfo::Info info;
+  info.register_reads = reads.calls;
+  info.register_read_mean_us = reads.meanInUs;
+  info.register_read_p99_us = reads.p99InUs;
+  info.register_read_max_us = reads.maxInUs;
+  info.register_writes = writes.calls;
+  info.register_write_mean_us = writes.meanInUs;
+  info.register_write_p99_us = writes.p99InUs;
+  info.register_write_max_us = writes.maxInUs;
+  info.data_receives = receives.calls;
+  info.data_receive_mean_us = receives.meanInUs;
+  info.data_receive_p99_us = receives.p99InUs;
+  info.data_receive_max_us = receives.maxInUs;
+
+  const PacketBuffer& packets = m_device_interface->GetPacketBuffer();
+  info.packet_buffer_bytes = packets.Footprint();
+  info.packet_buffer_high_water_bytes = packets.HighWaterFootprint();
+  info.evicted_packets = packets.EvictedPackets();
+  info.evicted_bytes = packets.EvictedBytes();
+  info.dropped_triggers = m_device_interface->DroppedTriggers();
+
+  // Board status. get_info runs alongside the command threads, so it is only
+  // read over a slow control session, never the main control connection
+  if (m_device_interface->HasSlowControlSession()) {
+    try {
+      unsigned int pdtsStatus = 0;
+      unsigned int timestampLsb = 0;
+      unsigned int timestampMsb = 0;
+      m_device_interface->ReadMonitorRegisterByName("pdts_status", pdtsStatus);
+      m_device_interface->ReadMonitorRegisterByName("live_timestamp_lsb", timestampLsb);
+      m_device_interface->ReadMonitorRegisterByName("live_timestamp_msb", timestampMsb);
+      info.pdts_status = pdtsStatus;
+      info.live_timestamp = (static_cast<uint64_t>(timestampMsb) << 32) | timestampLsb; // NOLINT(build/unsigned)
+    } catch (const std::exception& ex) {
+      TLOG_DEBUG(TLVL_WORK_STEPS) << "SSPLEDCalibWrapper::get_info: could not read the board status: " << ex.what();
+    }
+  }
+  ci.add(info);
+}
+
 void
 SSPLEDCalibWrapper::configure_single_pulse()
 {
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSPLEDCalibWrapper::ConfigureSinglePulse called.";
 
   m_device_interface->SetRegister(0x80000464, 0x00000200); //pdts_cmd_control_1
-  m_device_interface->SetRegister(0x80000940, 0x00030036); //pdts_cmd_delay_0
-  m_device_interface->SetRegister(0x80000944, 0x00030036); //pdts_cmd_delay_1
-  m_device_interface->SetRegister(0x80000948, 0x00030036); //pdts_cmd_delay_2
-  m_device_interface->SetRegister(0x8000094C, 0x00030036); //pdts_cmd_delay_3
-  m_device_interface->SetRegister(0x80000950, 0x00030036); //pdts_cmd_delay_4
-  m_device_interface->SetRegister(0x80000954, 0x00030036); //pdts_cmd_delay_5
-  m_device_interface->SetRegister(0x80000958, 0x00030036); //pdts_cmd_delay_6
-  m_device_interface->SetRegister(0x8000095C, 0x00030036); //pdts_cmd_delay_7
-  m_device_interface->SetRegister(0x80000960, 0x00030036); //pdts_cmd_delay_8
-  m_device_interface->SetRegister(0x80000964, 0x00030036); //pdts_cmd_delay_9
-  m_device_interface->SetRegister(0x80000968, 0x00030036); //pdts_cmd_delay_10
-  m_device_interface->SetRegister(0x8000096C, 0x00030036); //pdts_cmd_delay_11
-  m_device_interface->SetRegister(0x80000970, 0x00030036); //pdts_cmd_delay_12
-  m_device_interface->SetRegister(0x80000974, 0x00030036); //pdts_cmd_delay_13
-  m_device_interface->SetRegister(0x80000978, 0x00030036); //pdts_cmd_delay_14
-  m_device_interface->SetRegister(0x8000097C, 0x00030036); //pdts_cmd_delay_15
+  {
+    DeviceInterface::WriteBatch batch(*m_device_interface); // the delays go out as one array write
+    m_device_interface->SetRegister(0x80000940, 0x00030036); //pdts_cmd_delay_0
+    m_device_interface->SetRegister(0x80000944, 0x00030036); //pdts_cmd_delay_1
+    m_device_interface->SetRegister(0x80000948, 0x00030036); //pdts_cmd_delay_2
+    m_device_interface->SetRegister(0x8000094C, 0x00030036); //pdts_cmd_delay_3
+    m_device_interface->SetRegister(0x80000950, 0x00030036); //pdts_cmd_delay_4
+    m_device_interface->SetRegister(0x80000954, 0x00030036); //pdts_cmd_delay_5
+    m_device_interface->SetRegister(0x80000958, 0x00030036); //pdts_cmd_delay_6
+    m_device_interface->SetRegister(0x8000095C, 0x00030036); //pdts_cmd_delay_7
+    m_device_interface->SetRegister(0x80000960, 0x00030036); //pdts_cmd_delay_8
+    m_device_interface->SetRegister(0x80000964, 0x00030036); //pdts_cmd_delay_9
+    m_device_interface->SetRegister(0x80000968, 0x00030036); //pdts_cmd_delay_10
+    m_device_interface->SetRegister(0x8000096C, 0x00030036); //pdts_cmd_delay_11
+    m_device_interface->SetRegister(0x80000970, 0x00030036); //pdts_cmd_delay_12
+    m_device_interface->SetRegister(0x80000974, 0x00030036); //pdts_cmd_delay_13
+    m_device_interface->SetRegister(0x80000978, 0x00030036); //pdts_cmd_delay_14
+    m_device_interface->SetRegister(0x8000097C, 0x00030036); //pdts_cmd_delay_15
+    batch.Commit();
+  }
   m_device_interface->SetRegister(0x80000468, 0x80000000); //pdts_cmd_control_2
   m_device_interface->SetRegister(0x80000520, 0x00000011); //pulser_mode_control
   m_device_interface->SetRegister(0x80000448, 0x00000001); //cal_count
@@ -284,22 +373,26 @@ SSPLEDCalibWrapper::configure_burst_mode()
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSPLEDCalibWrapper::ConfigureBurstMode called.";
 
   m_device_interface->SetRegister(0x80000464, 0x00000200); //pdts_cmd_control_1
-  m_device_interface->SetRegister(0x80000940, 0x00030036); //pdts_cmd_delay_0
-  m_device_interface->SetRegister(0x80000944, 0x00030036); //pdts_cmd_delay_1
-  m_device_interface->SetRegister(0x80000948, 0x00030036); //pdts_cmd_delay_2
-  m_device_interface->SetRegister(0x8000094C, 0x00030036); //pdts_cmd_delay_3
-  m_device_interface->SetRegister(0x80000950, 0x00030036); //pdts_cmd_delay_4
-  m_device_interface->SetRegister(0x80000954, 0x00030036); //pdts_cmd_delay_5
-  m_device_interface->SetRegister(0x80000958, 0x00030036); //pdts_cmd_delay_6
-  m_device_interface->SetRegister(0x8000095C, 0x00030036); //pdts_cmd_delay_7
-  m_device_interface->SetRegister(0x80000960, 0x00030036); //pdts_cmd_delay_8
-  m_device_interface->SetRegister(0x80000964, 0x00030036); //pdts_cmd_delay_9
-  m_device_interface->SetRegister(0x80000968, 0x00030036); //pdts_cmd_delay_10
-  m_device_interface->SetRegister(0x8000096C, 0x00030036); //pdts_cmd_delay_11
-  m_device_interface->SetRegister(0x80000970, 0x00030036); //pdts_cmd_delay_12
-  m_device_interface->SetRegister(0x80000974, 0x00030036); //pdts_cmd_delay_13
-  m_device_interface->SetRegister(0x80000978, 0x00030036); //pdts_cmd_delay_14
-  m_device_interface->SetRegister(0x8000097C, 0x00030036); //pdts_cmd_delay_15
+  {
+    DeviceInterface::WriteBatch batch(*m_device_interface); // the delays go out as one array write
+    m_device_interface->SetRegister(0x80000940, 0x00030036); //pdts_cmd_delay_0
+    m_device_interface->SetRegister(0x80000944, 0x00030036); //pdts_cmd_delay_1
+    m_device_interface->SetRegister(0x80000948, 0x00030036); //pdts_cmd_delay_2
+    m_device_interface->SetRegister(0x8000094C, 0x00030036); //pdts_cmd_delay_3
+    m_device_interface->SetRegister(0x80000950, 0x00030036); //pdts_cmd_delay_4
+    m_device_interface->SetRegister(0x80000954, 0x00030036); //pdts_cmd_delay_5
+    m_device_interface->SetRegister(0x80000958, 0x00030036); //pdts_cmd_delay_6
+    m_device_interface->SetRegister(0x8000095C, 0x00030036); //pdts_cmd_delay_7
+    m_device_interface->SetRegister(0x80000960, 0x00030036); //pdts_cmd_delay_8
+    m_device_interface->SetRegister(0x80000964, 0x00030036); //pdts_cmd_delay_9
+    m_device_interface->SetRegister(0x80000968, 0x00030036); //pdts_cmd_delay_10
+    m_device_interface->SetRegister(0x8000096C, 0x00030036); //pdts_cmd_delay_11
+    m_device_interface->SetRegister(0x80000970, 0x00030036); //pdts_cmd_delay_12
+    m_device_interface->SetRegister(0x80000974, 0x00030036); //pdts_cmd_delay_13
+    m_device_interface->SetRegister(0x80000978, 0x00030036); //pdts_cmd_delay_14
+    m_device_interface->SetRegister(0x8000097C, 0x00030036); //pdts_cmd_delay_15
+    batch.Commit();
+  }
   m_device_interface->SetRegister(0x80000468, 0x80000000); //pdts_cmd_control_2
   m_device_interface->SetRegister(0x80000520, 0x00000011); //pulser_mode_control
   m_device_interface->SetRegister(0x80000448, m_burst_count); //cal_count
@@ -371,6 +464,15 @@ SSPLEDCalibWrapper::validate_config(const data_t& args)
     throw ConfigurationError(ERS_HERE, ss.str());
   }
   
+  PollStrategy::Mode_t poll_mode;
+  if (!PollStrategy::ParseMode(m_cfg.poll_strategy, poll_mode)) {
+    std::stringstream ss;
+    ss << "ERROR: Incorrect poll_strategy value is " << m_cfg.poll_strategy
+       << ", it must be adaptive, spin, or device." << std::endl;
+    TLOG() << ss.str();
+    throw ConfigurationError(ERS_HERE, ss.str());
+  }
+
   if (m_cfg.double_pulse_delay_ticks > 4095) {
     std::stringstream ss;
     ss << "ERROR: Strange!! double_pulse_delay_ticks value is " << m_cfg.double_pulse_delay_ticks << ", which is greater than the limit of 4095"
@@ -15,6 +15,7 @@
 #include "SSPIssues.hpp"
 #include "anlBoard/DeviceInterface.hpp"
 #include "logging/Logging.hpp"
+#include "opmonlib/InfoCollector.hpp"
 #include "readoutlibs/utils/ReusableThread.hpp"
 
 #include <nlohmann/json.hpp>
@@ -48,6 +49,7 @@ public:
   void configure(const data_t& args);
   void start(const data_t& args);
   void stop(const data_t& args);
+  void get_info(opmonlib::InfoCollector& ci, int level);
   
 private:
   // Types
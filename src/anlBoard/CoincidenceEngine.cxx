@@ -0,0 +1,106 @@
+/**
+ * @file CoincidenceEngine.cxx
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_COINCIDENCEENGINE_CXX_
+#define SSPMODULES_SRC_ANLBOARD_COINCIDENCEENGINE_CXX_
+
+#include "CoincidenceEngine.hpp"
+
+#include <algorithm>
+
+dunedaq::sspmodules::CoincidenceEngine::CoincidenceEngine(unsigned int nChannels,
+                                                          unsigned long windowInTicks) // NOLINT(runtime/int)
+  : fNChannels(std::min(nChannels, 16u))
+  , fWindow(windowInTicks)
+{
+  this->Reset();
+}
+
+void
+dunedaq::sspmodules::CoincidenceEngine::SetNChannels(unsigned int nChannels)
+{
+  fNChannels = std::min(nChannels, 16u);
+}
+
+void
+dunedaq::sspmodules::CoincidenceEngine::SetWindow(unsigned long windowInTicks) // NOLINT(runtime/int)
+{
+  fWindow = windowInTicks;
+}
+
+dunedaq::sspmodules::CoincidenceEngine::Result_t
+dunedaq::sspmodules::CoincidenceEngine::AddTrigger(unsigned int channel,
+                                                   unsigned long time,          // NOLINT(runtime/int)
+                                                   unsigned short triggerType)  // NOLINT(runtime/int)
+{
+  if (channel >= fNChannels) {
+    return kBadChannel;
+  }
+  this->Expire(time);
+
+  unsigned int bit = 1u << channel;
+  for (auto window = fWindows.lower_bound(time > fWindow ? time - fWindow : 0);
+       window != fWindows.end() && window->first < time + fWindow;
+       ++window) {
+    if (!(window->second.channelsSeen & bit)) {
+      window->second.channelsSeen |= bit;
+      return kCoincident;
+    }
+  }
+
+  fWindows.emplace(time, Window{ triggerType, bit });
+  return kNewTrigger;
+}
+
+void
+dunedaq::sspmodules::CoincidenceEngine::OpenWindow(unsigned int channel,
+                                                   unsigned long time,          // NOLINT(runtime/int)
+                                                   unsigned short triggerType)  // NOLINT(runtime/int)
+{
+  this->Expire(time);
+  fWindows.emplace(time, Window{ triggerType, channel < fNChannels ? 1u << channel : 0u });
+}
+
+bool
+dunedaq::sspmodules::CoincidenceEngine::DummyTriggerDue(unsigned long time, unsigned long period) // NOLINT(runtime/int)
+{
+  if (period == 0 || fLastDummyTrigger == time / period) {
+    return false;
+  }
+  fLastDummyTrigger = time / period;
+  return true;
+}
+
+unsigned int
+dunedaq::sspmodules::CoincidenceEngine::ChannelsSeen(unsigned long triggerTime) const // NOLINT(runtime/int)
+{
+  auto window = fWindows.find(triggerTime);
+  return window == fWindows.end() ? 0 : window->second.channelsSeen;
+}
+
+void
+dunedaq::sspmodules::CoincidenceEngine::Reset()
+{
+  fWindows.clear();
+  fLatestTime = 0;
+  fLastDummyTrigger = 0;
+}
+
+void
+dunedaq::sspmodules::CoincidenceEngine::Expire(unsigned long time) // NOLINT(runtime/int)
+{
+  fLatestTime = std::max(fLatestTime, time);
+
+  // A packet at most fWindow behind the latest one can still join a window
+  // up to fWindow before it
+  if (fLatestTime <= 2 * fWindow) {
+    return;
+  }
+  fWindows.erase(fWindows.begin(), fWindows.lower_bound(fLatestTime - 2 * fWindow));
+}
+
+#endif // SSPMODULES_SRC_ANLBOARD_COINCIDENCEENGINE_CXX_
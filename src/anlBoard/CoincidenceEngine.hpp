@@ -0,0 +1,86 @@
+/**
+ * @file CoincidenceEngine.hpp
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_COINCIDENCEENGINE_HPP_
+#define SSPMODULES_SRC_ANLBOARD_COINCIDENCEENGINE_HPP_
+
+#include <map>
+
+namespace dunedaq {
+namespace sspmodules {
+
+//Groups triggering packets from the channels of one board into triggers.
+//A packet joins an open trigger window within the coincidence window of its
+//timestamp which has not yet seen its channel, and otherwise opens a new
+//window. Any number of windows may be open and overlapping; they are held in
+//time order, so finding and opening one is logarithmic in the number open.
+//Windows are forgotten once packets can no longer arrive for them, assuming
+//channels are out of order with each other by less than the coincidence
+//window. Not thread safe; each DeviceInterface has its own.
+class CoincidenceEngine{
+
+public:
+
+  enum Result_t{kNewTrigger,kCoincident,kBadChannel};
+
+  //Boards have 5 or 12 channels; the channel field of the header allows up to 16
+  explicit CoincidenceEngine(unsigned int nChannels = 12, unsigned long windowInTicks = 1000);  // NOLINT(runtime/int)
+
+  void SetNChannels(unsigned int nChannels);
+
+  inline unsigned int NChannels() const{
+    return fNChannels;
+  }
+
+  void SetWindow(unsigned long windowInTicks);  // NOLINT(runtime/int)
+
+  //Add a triggering packet. kNewTrigger means it opened a window at its own time.
+  Result_t AddTrigger(unsigned int channel, unsigned long time, unsigned short triggerType);  // NOLINT(runtime/int)
+
+  //Open a window at time whatever is already open, as for a dummy trigger
+  void OpenWindow(unsigned int channel, unsigned long time, unsigned short triggerType);  // NOLINT(runtime/int)
+
+  //Whether time has moved into a new dummy trigger period since the last call
+  //which returned true
+  bool DummyTriggerDue(unsigned long time, unsigned long period);  // NOLINT(runtime/int)
+
+  //Mask of channels seen by the earliest window opened at triggerTime, or 0
+  //if there is none
+  unsigned int ChannelsSeen(unsigned long triggerTime) const;  // NOLINT(runtime/int)
+
+  inline unsigned int OpenWindows() const{
+    return fWindows.size();
+  }
+
+  void Reset();
+
+private:
+
+  struct Window{
+    unsigned short triggerType;  // NOLINT(runtime/int)
+    unsigned int channelsSeen;
+  };
+
+  //Drop windows which no packet from time onwards can join
+  void Expire(unsigned long time);  // NOLINT(runtime/int)
+
+  unsigned int fNChannels;
+
+  unsigned long fWindow;  // NOLINT(runtime/int)
+
+  //Keyed by trigger time
+  std::multimap<unsigned long, Window> fWindows;  // NOLINT(runtime/int)
+
+  unsigned long fLatestTime;  // NOLINT(runtime/int)
+
+  unsigned long fLastDummyTrigger;  // NOLINT(runtime/int)
+};
+
+} // namespace sspmodules
+} // namespace dunedaq
+
+#endif // SSPMODULES_SRC_ANLBOARD_COINCIDENCEENGINE_HPP_
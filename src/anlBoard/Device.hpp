@@ -10,6 +10,9 @@
 
 //#include "ftd2xx.h"
 
+#include "DeviceStats.hpp"
+
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <iomanip>
@@ -17,6 +20,7 @@
 #include <stdint.h>
 #include <string>
 #include <unistd.h>
+#include <utility>
 #include <vector>
 
 namespace dunedaq {
@@ -48,12 +52,70 @@ public:
   // Flush data channel
   virtual void DevicePurgeData() = 0;
 
+  // What the last DevicePurgeComm or DevicePurgeData threw away, and how long it took
+  struct PurgeReport
+  {
+    unsigned long bytes; // NOLINT(runtime/int)
+    unsigned int timeInUs;
+  };
+
+  virtual PurgeReport LastPurge() const { return PurgeReport{ 0, 0 }; }
+
   // Get number of bytes in data queue (put into numWords)
   virtual void DeviceQueueStatus(unsigned int* numWords) = 0;
 
   // Read data into vector, up to defined size
   virtual void DeviceReceive(std::vector<unsigned int>& data, unsigned int size) = 0;
 
+  // One caller-owned destination for DeviceReceiveV
+  struct ReceiveSegment
+  {
+    unsigned int* data;
+    unsigned int size;
+  };
+
+  // Read data into several buffers in one go, filling each in turn, up to
+  // their total size. Returns the number of words received.
+  // By default this does one DeviceReceive per segment, stopping at the first
+  // which comes back short.
+  virtual unsigned int DeviceReceiveV(const ReceiveSegment* segments, unsigned int nSegments)
+  {
+    std::vector<unsigned int> data;
+    unsigned int received = 0;
+    for (unsigned int i = 0; i < nSegments; ++i) {
+      DeviceReceive(data, segments[i].size);
+      std::copy(data.begin(), data.end(), segments[i].data);
+      received += data.size();
+      if (data.size() < segments[i].size) {
+        break;
+      }
+    }
+    return received;
+  }
+
+  // Block until at least one word is queued on the data channel, or until
+  // timeoutInUs has passed. Returns whether data is available.
+  // By default this polls DeviceQueueStatus every 100us, or sooner if the
+  // timeout is up sooner.
+  virtual bool DeviceWaitForData(unsigned int timeoutInUs)
+  {
+    unsigned int numWords = 0;
+    unsigned int timeWaited = 0;
+    while (true) {
+      DeviceQueueStatus(&numWords);
+      if (numWords || timeWaited >= timeoutInUs) {
+        return numWords != 0;
+      }
+      unsigned int interval = std::min(100u, timeoutInUs - timeWaited);
+      usleep(interval);
+      timeWaited += interval;
+    }
+  }
+
+  // Switch the data channel between polled reads and asynchronous reception
+  // into an internal buffer. Devices which can only poll ignore this.
+  virtual void DeviceAsyncReceive(bool /*enable*/) {}
+
   //============================//
   // Read from/write to registers//
   //============================//
@@ -79,11 +141,41 @@ public:
   // Write series of contiguous registers, number to write given in "size"
   virtual void DeviceArrayWrite(unsigned int address, unsigned int size, unsigned int* data) = 0;
 
+  // Write a list of (address, value) pairs, not necessarily contiguous.
+  // Implementations may overlap the individual transactions on the link;
+  // by default they are simply issued one after another.
+  virtual void DeviceWriteList(const std::vector<std::pair<unsigned int, unsigned int>>& writes)
+  {
+    for (auto write = writes.begin(); write != writes.end(); ++write) {
+      DeviceWrite(write->first, write->second);
+    }
+  }
+
+  // Read a register from the hardware even if the device keeps a cached
+  // copy of it, updating the copy. By default nothing is cached.
+  virtual void DeviceReadForced(unsigned int address, unsigned int* value)
+  {
+    DeviceRead(address, value);
+  }
+
+  // Forget any cached register values, e.g. after the board has been reset
+  virtual void DeviceInvalidateCache() {}
+
   //=============================
 
+  // Call counts and latencies of the operations above. Implementations
+  // time each call once, under its own operation; the default DeviceReceiveV,
+  // DeviceWriteList and DeviceReadForced above are counted as the calls they
+  // are made of.
+  const DeviceStats& Stats() const { return fStats; }
+
+  void ResetStats() { fStats.Reset(); }
+
 protected:
   bool fSlowControlOnly;
 
+  DeviceStats fStats;
+
 private:
   // Device can only be opened from the DeviceManager.
   virtual void Open(bool slowControlOnly = false) = 0;
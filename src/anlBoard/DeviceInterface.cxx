@@ -21,8 +21,12 @@
 #include "boost/asio.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <ctime>
+#include <exception>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -37,9 +41,13 @@ enum
 
 // SSPDAQ::DeviceInterface::DeviceInterface(SSPDAQ::Comm_t commType, unsigned long deviceId)
 dunedaq::sspmodules::DeviceInterface::DeviceInterface(dunedaq::fddetdataformats::ssp::Comm_t commType)
-  : fCommType(commType)
+  : fDevice(0)
+  , fSlowControlDevice(0)
+  , fCommType(commType)
   , fDeviceId(0)
   , fState(dunedaq::sspmodules::DeviceInterface::kUninitialized)
+  , fWriteBatchDepth(0)
+  , fAsyncReceive(false)
   , fUseExternalTimestamp(true)
   , fHardwareClockRateInMHz(128)
   , fPreTrigLength(1E8)
@@ -51,8 +59,14 @@ dunedaq::sspmodules::DeviceInterface::DeviceInterface(dunedaq::fddetdataformats:
   , fSlowControlOnly(false)
   , fPartitionNumber(0)
   , fTimingAddress(0)
+  , fMaxPendingTriggers(1024)
+  , fDroppedTriggers(0)
   , exception_(false)
   , fDataThread(0)
+  , fDispatchThread(0)
+  , fFrameRing(1024)
+  , fTruncatedFrames(0)
+  , fUnroutedFrames(0)
 {
   //, fRequestReceiver(0){
 }
@@ -84,6 +98,58 @@ dunedaq::sspmodules::DeviceInterface::OpenSlowControl()
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface OpenSlowControl completed.";
 }
 
+void
+dunedaq::sspmodules::DeviceInterface::OpenSlowControlSession()
+{
+  std::lock_guard<std::mutex> lock(fSlowControlMutex);
+  if (fSlowControlDevice) {
+    return;
+  }
+
+  TLOG_DEBUG(TLVL_WORK_STEPS) << "Opening slow control session to device #" << fDeviceId << " for monitoring..."
+                              << std::endl;
+  fSlowControlDevice = dunedaq::sspmodules::DeviceManager::Get().OpenSlowControlSession(fCommType, fDeviceId);
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface OpenSlowControlSession completed.";
+}
+
+bool
+dunedaq::sspmodules::DeviceInterface::HasSlowControlSession()
+{
+  std::lock_guard<std::mutex> lock(fSlowControlMutex);
+  return fSlowControlDevice != 0;
+}
+
+void
+dunedaq::sspmodules::DeviceInterface::Open()
+{
+
+  TLOG_DEBUG(TLVL_FULL_DEBUG) << "SSP Device Interface Open called.";
+  // Ask device manager for a pointer to the specified device
+  dunedaq::sspmodules::DeviceManager& devman = dunedaq::sspmodules::DeviceManager::Get();
+  dunedaq::sspmodules::Device* device = 0;
+
+  TLOG_DEBUG(TLVL_WORK_STEPS) << "Opening "
+                              << ((fCommType == dunedaq::fddetdataformats::ssp::kUSB)
+                                    ? "USB"
+                                    : ((fCommType == dunedaq::fddetdataformats::ssp::kEthernet) ? "Ethernet" : "Emulated"))
+                              << " device #" << fDeviceId << "..." << std::endl;
+
+  device = devman.OpenDevice(fCommType, fDeviceId);
+
+  if (!device) {
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Unable to get handle to device; giving up!" << std::endl;
+    throw(ENoSuchDevice());
+  }
+
+  fDevice = device;
+  fSlowControlOnly = false;
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface Open completed.";
+}
+
+namespace {
+const unsigned int headerSizeInWords = sizeof(dunedaq::fddetdataformats::ssp::EventHeader) / sizeof(unsigned int);
+}
+
 inline void
 tokenize(std::string const& str, const char delim, std::vector<std::string>& out)
 {
@@ -115,6 +181,11 @@ dunedaq::sspmodules::DeviceInterface::Initialize(const nlohmann::json& args)
       try {
         linkid = std::stoi(words.back());
 
+        if (linkid < 0 || static_cast<unsigned int>(linkid) >= kNChannels) {
+          TLOG() << "SSP Channel ID " << linkid << " parsed from queue instance name " << qi.uid
+                 << " is out of range, queue will not be used!";
+          continue;
+        }
         m_sink_queues[linkid] = get_iom_sender<dunedaq::fdreadoutlibs::types::SSPFrameTypeAdapter>(qi.uid);
       } catch (const std::exception& ex) {
         TLOG() << "SSP Channel ID could not be parsed on queue instance name!";
@@ -144,9 +215,34 @@ dunedaq::sspmodules::DeviceInterface::Stop()
     //}
     TLOG_DEBUG(TLVL_WORK_STEPS) << "Signalling read thread to end..." << std::endl;
     fDataThread->join();
-    TLOG_DEBUG(TLVL_WORK_STEPS) << "Read thread terminated!" << std::endl;
+    delete fDataThread;
+    fDataThread = 0;
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Read thread terminated! It slept " << fPollStrategy.Sleeps()
+                                << " times waiting for data" << std::endl;
+
+    // Let the dispatcher empty the ring, then stop it
+    fDispatchShouldStop = true;
+    fDispatchThread->join();
+    delete fDispatchThread;
+    fDispatchThread = 0;
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Dispatch thread terminated! Frame ring high water mark was "
+                                << fFrameRing.high_water() << " of " << fFrameRing.capacity() << ", "
+                                << fFrameRing.overruns() << " events dropped on overrun, " << fTruncatedFrames
+                                << " truncated to fit a frame, " << fUnroutedFrames
+                                << " dropped with no sink queue for their channel" << std::endl;
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Packet buffer: " << fPacketBuffer.Footprint() << " bytes held, high water mark "
+                                << fPacketBuffer.HighWaterFootprint() << " bytes, " << fPacketBuffer.EvictedPackets()
+                                << " packets (" << fPacketBuffer.EvictedBytes() << " bytes) evicted, "
+                                << fDroppedTriggers << " triggers dropped" << std::endl;
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Fragment buffer pool: " << fFragmentPool.Hits() << " hits, "
+                                << fFragmentPool.Misses() << " misses, " << fFragmentPool.Available()
+                                << " buffers free, typical fragment " << fFragmentPool.TypicalWords() << " words"
+                                << std::endl;
   }
 
+  // Hand the data socket back to the polled path before purging it
+  fDevice->DeviceAsyncReceive(false);
+
   dunedaq::sspmodules::RegMap& duneReg = dunedaq::sspmodules::RegMap::Get();
 
   fDevice->DeviceWrite(duneReg.eventDataControl, 0x0013001F);
@@ -158,8 +254,16 @@ dunedaq::sspmodules::DeviceInterface::Stop()
   fDevice->DeviceWrite(duneReg.event_data_control, 0x00020001);
   // Flush RX buffer
   fDevice->DevicePurgeData();
+  dunedaq::sspmodules::Device::PurgeReport purge = fDevice->LastPurge();
+  TLOG_DEBUG(TLVL_WORK_STEPS) << "Purged " << purge.bytes << " bytes from data channel in " << purge.timeInUs << " us"
+                              << std::endl;
+  fReadBuffer.Clear();
   TLOG_DEBUG(TLVL_WORK_STEPS) << "Hardware set to stopped state" << std::endl;
 
+  std::stringstream stats;
+  this->DumpDeviceStats(stats);
+  TLOG_DEBUG(TLVL_WORK_STEPS) << "Device operation latencies since configure:" << std::endl << stats.str();
+
   if (fState == dunedaq::sspmodules::DeviceInterface::kRunning) {
     TLOG_DEBUG(TLVL_WORK_STEPS) << "DeviceInterface stop transition complete!" << std::endl;
   }
@@ -214,10 +318,30 @@ dunedaq::sspmodules::DeviceInterface::Start()
   // Release master logic reset & enable active channels
 
   fDevice->DeviceWrite(duneReg.master_logic_control, 0x00000041);
-
+  // Coming out of reset the board may not hold what we last wrote to it
+  fDevice->DeviceInvalidateCache();
+
+  fReadBuffer.Clear();
+  fPacketBuffer.Clear();
+  fPacketBuffer.ResetStats();
+  fFragmentPool.Reserve(8);
+  fDroppedTriggers = 0;
+  fPollStrategy.Reset();
+  fCoincidence.Reset();
+  if (fAsyncReceive) {
+    fDevice->DeviceAsyncReceive(true);
+  }
   fState = dunedaq::sspmodules::DeviceInterface::kRunning;
   fShouldStop = false;
 
+  fDispatchShouldStop = false;
+  fFrameRing.reset_stats();
+  fTruncatedFrames = 0;
+  fUnroutedFrames = 0;
+
+  TLOG_DEBUG(TLVL_WORK_STEPS) << "Starting dispatch thread..." << std::endl;
+  fDispatchThread = new std::thread(&dunedaq::sspmodules::DeviceInterface::DispatchLoop, this);
+
   TLOG_DEBUG(TLVL_WORK_STEPS) << "Starting read thread..." << std::endl;
   fDataThread = new std::thread(&dunedaq::sspmodules::DeviceInterface::HardwareReadLoop, this);
   TLOG_DEBUG(TLVL_WORK_STEPS) << "Read thread is up!" << std::endl;
@@ -244,28 +368,40 @@ dunedaq::sspmodules::DeviceInterface::HardwareReadLoop()
     // Read an event from SSP. If there is no data, break. //
     /////////////////////////////////////////////////////////
 
-    dunedaq::sspmodules::EventPacket newPacket;
-    this->ReadEventFromDevice(newPacket);
-    if (newPacket.header.header != 0xAAAAAAAA) {
-      usleep(1000);
+    // Decode straight into the next free ring slot. If the dispatcher has fallen
+    // behind, keep draining the device anyway and drop the event.
+    dunedaq::fdreadoutlibs::types::SSPFrameTypeAdapter* frame = fFrameRing.write_slot();
+    bool haveSlot = (frame != 0);
+    if (!haveSlot) {
+      frame = &fOverrunFrame;
+    }
+
+    if (!this->ReadFrameFromDevice(*frame)) {
+      fPollStrategy.Wait(fDevice, 1, 1000);
       continue;
     }
 
-    newPacket.DumpHeader();
-    TLOG_DEBUG(TLVL_BOOKKEEPING) << std::endl << " GetTimestamp return value before modification: " << GetTimestamp(newPacket.header)
+    TLOG_DEBUG(TLVL_BOOKKEEPING) << std::endl << " GetTimestamp return value before modification: " << GetTimestamp(frame->header)
 				<< std::endl;
-    unsigned long m_external_packetTime = GetTimestamp(newPacket.header);
+    unsigned long m_external_packetTime = GetTimestamp(frame->header);
     unsigned long m_corrected_external_packetTime = 0;
     m_corrected_external_packetTime = (m_external_packetTime + fFragmentTimestampOffset)/3;
     TLOG_DEBUG(TLVL_BOOKKEEPING) << std::endl << " External timestamp straight from the header: " << m_external_packetTime
 				<< std::endl;
     TLOG_DEBUG(TLVL_BOOKKEEPING) << std::endl << " modified external timestamp after removing offset and dividing by 3: " << m_corrected_external_packetTime
 				<< std::endl;
-    this->SetExternalTimestamp(newPacket.header, m_corrected_external_packetTime);
-    newPacket.DumpHeader();
-    TLOG_DEBUG(TLVL_BOOKKEEPING) << std::endl << " GetTimestamp return value after modification: " << GetTimestamp(newPacket.header)
+    this->SetExternalTimestamp(frame->header, m_corrected_external_packetTime);
+    TLOG_DEBUG(TLVL_BOOKKEEPING) << std::endl << " GetTimestamp return value after modification: " << GetTimestamp(frame->header)
 				<< std::endl;
 
+    if (haveSlot) {
+      fFrameRing.commit_write();
+    } else {
+      fFrameRing.record_overrun();
+      TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier() << "Warning: frame ring full, dropped event ("
+                                  << fFrameRing.overruns() << " dropped so far)" << std::endl;
+    }
+
     //    unsigned long m_external_packetTime = 0;
     //    for(unsigned int iWord=0;iWord<=3;++iWord){
     //      m_external_packetTime += ((unsigned long)(newPacket.header.timestamp[iWord]))<<16*iWord;
@@ -278,7 +414,7 @@ dunedaq::sspmodules::DeviceInterface::HardwareReadLoop()
     //    unsigned long m_internal_pretrig_time = m_internal_packetTime - fPreTrigLength;
     //    unsigned long m_internal_posttrig_time = m_internal_packetTime + fPostTrigLength;
     //
-    //    TLOG_DEBUG(TLVL_WORK_STEPS) << std::endl << " GetTimestamp return value: " << GetTimestamp(newPacket.header)
+    //    TLOG_DEBUG(TLVL_WORK_STEPS) << std::endl << " GetTimestamp return value: " << GetTimestamp(packet->header)
     //    << std::endl
     //                                << " external packetTime: " << m_external_packetTime << std::endl
     //				<< " raw internal packetTime: " << m_internal_packetTime
@@ -287,26 +423,58 @@ dunedaq::sspmodules::DeviceInterface::HardwareReadLoop()
     //				<< " scaled internal packetTime: " << m_internal_packetTime/3
     //                                << " scaled internal pretrig Time: " << m_internal_pretrig_time/3
     //                                << " scaled internal posttrig Time: " << m_internal_posttrig_time/3;
+  }
+  TLOG_DEBUG(TLVL_WORK_STEPS) << "HWRead thread ending" << std::endl;
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface HardwareReadLoop complete.";
+}
+
+void
+dunedaq::sspmodules::DeviceInterface::DispatchLoop()
+{
 
-    TLOG_DEBUG(TLVL_WORK_STEPS) << "HWRead getting mutex..." << std::endl;
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface DispatchLoop called.";
+
+  while (true) {
+
+    dunedaq::fdreadoutlibs::types::SSPFrameTypeAdapter* frame = fFrameRing.read_slot();
+    if (!frame) {
+      // The reader has already been joined when this is set, so an empty
+      // ring means everything has been dispatched
+      if (fDispatchShouldStop) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      continue;
+    }
+
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Dispatch getting mutex..." << std::endl;
     std::unique_lock<std::mutex> mlock(fBufferMutex);
-    TLOG_DEBUG(TLVL_WORK_STEPS) << "HWRead got mutex!" << std::endl;
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Dispatch got mutex!" << std::endl;
 
     /////////////////////////////////////////////////////////
     // Push event onto deque.                              //
     /////////////////////////////////////////////////////////
 
-    dunedaq::fdreadoutlibs::types::SSPFrameTypeAdapter sspfs;
-    sspfs.header = newPacket.header;
-    // memcpy();
-    memcpy(sspfs.data, newPacket.data.data(), newPacket.data.size());
+    if (fDispatchCallback) {
+      fDispatchCallback(*frame);
+    }
 
-    auto chid = ((newPacket.header.group2 & 0x000F) >> 0);
-    TLOG_DEBUG(TLVL_WORK_STEPS) << "Getting ready to write newPacket to chid: " << chid << std::endl;
-    m_sink_queues[chid]->send(std::move(sspfs), std::chrono::milliseconds(10));
+    auto chid = ((frame->header.group2 & 0x000F) >> 0);
+    auto& sink = m_sink_queues[chid];
+    if (!sink) {
+      // No queue configured for this channel; count the frame and drop it
+      if (fUnroutedFrames++ == 0) {
+        TLOG() << "No sink queue configured for SSP channel " << chid
+               << ", dropping its frames (further drops are only counted)";
+      }
+      fFrameRing.commit_read();
+      continue;
+    }
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Getting ready to write frame to chid: " << chid << std::endl;
+    sink->send(std::move(*frame), std::chrono::milliseconds(10));
     TLOG_DEBUG(TLVL_WORK_STEPS) << "Guess it wasn't writing to the sink_queues... " << chid << std::endl;
 
-    // fPacketBuffer.emplace_back(std::move(newPacket));
+    // fPacketBuffer.Push(std::move(newPacket), GetTimestamp(newPacket.header));
 
     ///////////////////////////////////////////////////////////////
     // Pass event to trigger finder method. If it contains       //
@@ -330,7 +498,7 @@ dunedaq::sspmodules::DeviceInterface::HardwareReadLoop()
     //	newTrigger.startTime=localTimestamp-fPreTrigLength;
     //	newTrigger.endTime=localTimestamp+fPostTrigLength;
     //	newTrigger.triggerType=0xFFFF;
-    //	fTriggers.push(newTrigger);
+    //	this->QueueTrigger(newTrigger);
     //      }
     //    }
     //    else{
@@ -344,7 +512,7 @@ dunedaq::sspmodules::DeviceInterface::HardwareReadLoop()
     //	  //	set_exception(true);
     //	  return;
     //	}
-    //	fTriggers.push(newTrigger);
+    //	this->QueueTrigger(newTrigger);
     //      }
     //    }
     //
@@ -377,11 +545,12 @@ dunedaq::sspmodules::DeviceInterface::HardwareReadLoop()
     //				<< " globalTS: " << globalTimestamp
     //				<< " dropped: " << dropCount;
 
-    TLOG_DEBUG(TLVL_WORK_STEPS) << "HWRead releasing mutex..." << std::endl;
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Dispatch releasing mutex..." << std::endl;
     mlock.unlock();
+    fFrameRing.commit_read();
   }
-  TLOG_DEBUG(TLVL_WORK_STEPS) << "HWRead thread ending" << std::endl;
-  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface HardwareReadLoop complete.";
+  TLOG_DEBUG(TLVL_WORK_STEPS) << "Dispatch thread ending" << std::endl;
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface DispatchLoop complete.";
 }
 
 void
@@ -403,17 +572,31 @@ dunedaq::sspmodules::DeviceInterface::ReadEvent(std::vector<unsigned int>& fragm
   TLOG_DEBUG(TLVL_WORK_STEPS) << "ReadEvent thread getting mutex..." << std::endl;
   std::unique_lock<std::mutex> mlock(fBufferMutex);
 
-  if (!fTriggers.size()) {
+  if (!fTriggers.size() || fPacketBuffer.Empty()) {
     return;
   }
   TLOG_DEBUG(TLVL_WORK_STEPS) << "ReadEvent thread got mutex!" << std::endl;
-  unsigned long packetTime = GetTimestamp(fPacketBuffer.back().header); // NOLINT(runtime/int)
+  unsigned long packetTime = fPacketBuffer.LatestTime(); // NOLINT(runtime/int)
 
   TLOG_DEBUG(TLVL_WORK_STEPS) << "packetTime: " << packetTime;
 
   if (packetTime > fTriggers.front().endTime + fTriggerWriteDelay) {
     this->BuildFragment(fTriggers.front(), fragment);
     fTriggers.pop();
+
+    // Keep what the oldest pending trigger still needs, or what a trigger
+    // arriving now could still reach back to
+    unsigned long firstInterestingTime; // NOLINT(runtime/int)
+    if (fTriggers.size()) {
+      firstInterestingTime = fTriggers.front().startTime;
+    } else {
+      unsigned long lookBack = fPreTrigLength + fTriggerLatency; // NOLINT(runtime/int)
+      firstInterestingTime = packetTime > lookBack ? packetTime - lookBack : 0;
+    }
+    firstInterestingTime = firstInterestingTime > fTriggerWriteDelay ? firstInterestingTime - fTriggerWriteDelay : 0;
+    unsigned int nDropped = fPacketBuffer.ReleaseBefore(firstInterestingTime);
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Released " << nDropped << " packets older than " << firstInterestingTime
+                                << ", " << fPacketBuffer.Size() << " still buffered" << std::endl;
   }
   TLOG_DEBUG(TLVL_WORK_STEPS) << "ReadEvent thread releasing mutex..." << std::endl;
   mlock.unlock();
@@ -427,49 +610,43 @@ dunedaq::sspmodules::DeviceInterface::GetTriggerInfo(const dunedaq::sspmodules::
 {
 
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface GetTriggerInfo called.";
-  static unsigned long currentTriggerTime = 0; // NOLINT(runtime/int)
-  static bool channelsSeen[12] = { false };
 
-  static unsigned long lastDummyTrigger = 0; // NOLINT(runtime/int)
-
-  int channel = event.header.group2 & 0x000F;
+  unsigned int channel = event.header.group2 & 0x000F;
   unsigned long packetTime = GetTimestamp(event.header); // NOLINT(runtime/int)
+  unsigned short triggerType = event.header.group1 & 0xFFFF; // NOLINT(runtime/int)
 
-  if (fDummyPeriod > 0 && (lastDummyTrigger != packetTime / fDummyPeriod)) {
+  if (fDummyPeriod > 0 && fCoincidence.DummyTriggerDue(packetTime, fDummyPeriod)) {
     TLOG_DEBUG(TLVL_WORK_STEPS) << "Generating dummy trigger for packet around " << packetTime << "!" << std::endl;
-    lastDummyTrigger = packetTime / fDummyPeriod;
-    currentTriggerTime = packetTime;
-    newTrigger.startTime = currentTriggerTime - fPreTrigLength;
-    newTrigger.endTime = currentTriggerTime + fPostTrigLength;
-    newTrigger.triggerType = event.header.group1 & 0xFFFF;
-
-    for (unsigned int i = 0; i < 12; ++i) {
-      channelsSeen[i] = false;
-    }
-    channelsSeen[channel] = true;
+    fCoincidence.OpenWindow(channel, packetTime, triggerType);
+    newTrigger.triggerTime = packetTime;
+    newTrigger.startTime = packetTime - fPreTrigLength;
+    newTrigger.endTime = packetTime + fPostTrigLength;
+    newTrigger.triggerType = triggerType;
     return true;
   }
 
-  if (((event.header.group1 & 0xFFFF) & fTriggerMask) != 0) {
-
-    if (!channelsSeen[channel] && packetTime < currentTriggerTime + 1000) {
-      channelsSeen[channel] = true;
-      TLOG_DEBUG(TLVL_WORK_STEPS)
-        << "Packet contains trigger word but this trigger was already generated from another channel" << std::endl;
-    } else {
-      currentTriggerTime = packetTime;
-      newTrigger.triggerTime = currentTriggerTime;
-      newTrigger.startTime = currentTriggerTime - fPreTrigLength;
-      newTrigger.endTime = currentTriggerTime + fPostTrigLength;
-      newTrigger.triggerType = event.header.group1 & 0xFFFF;
-      auto globalTimestamp = (packetTime + fFragmentTimestampOffset) / 3;
-      TLOG_DEBUG(TLVL_WORK_STEPS) << "Seen packet containing global trigger, timestamp " << packetTime << " / "
-                                  << globalTimestamp << std::endl;
-      for (unsigned int i = 0; i < 12; ++i) {
-        channelsSeen[i] = false;
+  if ((triggerType & fTriggerMask) != 0) {
+    switch (fCoincidence.AddTrigger(channel, packetTime, triggerType)) {
+      case CoincidenceEngine::kNewTrigger: {
+        newTrigger.triggerTime = packetTime;
+        newTrigger.startTime = packetTime - fPreTrigLength;
+        newTrigger.endTime = packetTime + fPostTrigLength;
+        newTrigger.triggerType = triggerType;
+        auto globalTimestamp = (packetTime + fFragmentTimestampOffset) / 3;
+        TLOG_DEBUG(TLVL_WORK_STEPS) << "Seen packet containing global trigger, timestamp " << packetTime << " / "
+                                    << globalTimestamp << ", " << fCoincidence.OpenWindows() << " trigger windows open"
+                                    << std::endl;
+        return true;
       }
-      channelsSeen[channel] = true;
-      return true;
+      case CoincidenceEngine::kCoincident:
+        TLOG_DEBUG(TLVL_WORK_STEPS)
+          << "Packet contains trigger word but this trigger was already generated from another channel" << std::endl;
+        return false;
+      case CoincidenceEngine::kBadChannel:
+        TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier() << "Warning: trigger packet from channel " << channel
+                                    << " on a " << fCoincidence.NChannels() << " channel board; ignoring it"
+                                    << std::endl;
+        return false;
     }
   }
   TLOG_DEBUG(TLVL_WORK_STEPS) << "Packet contains no trigger... trigger logic will ignore it." << std::endl;
@@ -478,6 +655,19 @@ dunedaq::sspmodules::DeviceInterface::GetTriggerInfo(const dunedaq::sspmodules::
   return false;
 }
 
+void
+dunedaq::sspmodules::DeviceInterface::QueueTrigger(const dunedaq::sspmodules::TriggerInfo& trigger)
+{
+  if (fMaxPendingTriggers && fTriggers.size() >= fMaxPendingTriggers) {
+    if (fDroppedTriggers++ == 0) {
+      TLOG() << this->GetIdentifier() << "Warning: " << fTriggers.size()
+             << " triggers already waiting to be built, dropping the oldest (further drops are only counted)";
+    }
+    fTriggers.pop();
+  }
+  fTriggers.push(trigger);
+}
+
 void
 dunedaq::sspmodules::DeviceInterface::BuildFragment(const dunedaq::sspmodules::TriggerInfo& theTrigger,
                                                     std::vector<unsigned int>& fragmentData)
@@ -485,35 +675,12 @@ dunedaq::sspmodules::DeviceInterface::BuildFragment(const dunedaq::sspmodules::T
 
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface BuildFragment called.";
 
-  std::vector<dunedaq::sspmodules::EventPacket> eventsToPutBack;
-  std::vector<dunedaq::sspmodules::EventPacket*> eventsToWrite;
+  // Packets in the window are contiguous in the time-ordered buffer
+  std::pair<unsigned int, unsigned int> window = fPacketBuffer.Window(theTrigger.startTime, theTrigger.endTime);
+  unsigned int nEvents = window.second - window.first;
 
-  auto lastPacket = fPacketBuffer.begin();
-
-  for (auto packetIter = fPacketBuffer.begin(); packetIter != fPacketBuffer.end(); ++packetIter) {
-    unsigned long packetTime = GetTimestamp(packetIter->header); // NOLINT(runtime/int)
-
-    TLOG_DEBUG(TLVL_WORK_STEPS) << "packetTime=" << packetTime << " triggerTime=[" << theTrigger.startTime << " to "
-                                << theTrigger.endTime << "]";
-
-    if (packetTime >= theTrigger.startTime && packetTime < theTrigger.endTime) {
-      lastPacket = packetIter;
-    }
-  }
-
-  for (auto packetIter = fPacketBuffer.begin();; ++packetIter) {
-    unsigned long packetTime = GetTimestamp(packetIter->header); // NOLINT(runtime/int)
-
-    if (packetTime >= theTrigger.startTime) {
-      if (packetTime >= theTrigger.endTime) {
-        eventsToPutBack.push_back(std::move(*packetIter));
-      } else {
-        eventsToWrite.push_back(&*packetIter);
-      }
-    }
-    if (packetIter == lastPacket)
-      break;
-  }
+  TLOG_DEBUG(TLVL_WORK_STEPS) << "triggerTime=[" << theTrigger.startTime << " to " << theTrigger.endTime << "] holds "
+                              << nEvents << " of " << fPacketBuffer.Size() << " buffered packets";
 
   //=====================================//
   // Calculate required size of millislice//
@@ -522,8 +689,8 @@ dunedaq::sspmodules::DeviceInterface::BuildFragment(const dunedaq::sspmodules::T
   unsigned int dataSizeInWords = 0;
 
   dataSizeInWords += dunedaq::fddetdataformats::ssp::MillisliceHeader::sizeInUInts;
-  for (auto ev = eventsToWrite.begin(); ev != eventsToWrite.end(); ++ev) {
-    dataSizeInWords += (*ev)->header.length;
+  for (unsigned int i = window.first; i < window.second; ++i) {
+    dataSizeInWords += fPacketBuffer.At(i).header.length;
   }
 
   //==================//
@@ -532,7 +699,7 @@ dunedaq::sspmodules::DeviceInterface::BuildFragment(const dunedaq::sspmodules::T
 
   dunedaq::fddetdataformats::ssp::MillisliceHeader sliceHeader;
   sliceHeader.length = dataSizeInWords;
-  sliceHeader.nTriggers = eventsToWrite.size();
+  sliceHeader.nTriggers = nEvents;
   sliceHeader.startTime = theTrigger.startTime;
   sliceHeader.endTime = theTrigger.endTime;
   sliceHeader.triggerTime = theTrigger.triggerTime;
@@ -542,6 +709,7 @@ dunedaq::sspmodules::DeviceInterface::BuildFragment(const dunedaq::sspmodules::T
   // Allocate space for whole slice and fill with data//
   //=================================================//
 
+  fFragmentPool.Acquire(fragmentData, dataSizeInWords);
   fragmentData.resize(dataSizeInWords);
 
   static unsigned int headerSizeInWords =
@@ -556,18 +724,19 @@ dunedaq::sspmodules::DeviceInterface::BuildFragment(const dunedaq::sspmodules::T
   // Fill rest of vector with event data
   sliceDataPtr += dunedaq::fddetdataformats::ssp::MillisliceHeader::sizeInUInts;
 
-  for (auto ev = eventsToWrite.begin(); ev != eventsToWrite.end(); ++ev) {
+  for (unsigned int i = window.first; i < window.second; ++i) {
+    const dunedaq::sspmodules::EventPacket& ev = fPacketBuffer.At(i);
     // DAQ event header
-    unsigned int* headerPtr = static_cast<unsigned int*>(static_cast<void*>(&((*ev)->header)));
+    const unsigned int* headerPtr = static_cast<const unsigned int*>(static_cast<const void*>(&ev.header));
     std::copy(headerPtr, headerPtr + headerSizeInWords, sliceDataPtr);
 
     // DAQ event payload
     sliceDataPtr += headerSizeInWords;
-    std::copy((*ev)->data.begin(), (*ev)->data.end(), sliceDataPtr);
-    sliceDataPtr += (*ev)->header.length - headerSizeInWords;
+    std::copy(ev.data.begin(), ev.data.end(), sliceDataPtr);
+    sliceDataPtr += ev.header.length - headerSizeInWords;
   }
 
-  TLOG_DEBUG(TLVL_WORK_STEPS) << "Building fragment with " << eventsToWrite.size() << " packets" << std::endl;
+  TLOG_DEBUG(TLVL_WORK_STEPS) << "Building fragment with " << nEvents << " packets" << std::endl;
 
   //=======================//
   // Add millislice to queue//
@@ -578,24 +747,6 @@ dunedaq::sspmodules::DeviceInterface::BuildFragment(const dunedaq::sspmodules::T
   // "<<startTime<<" onto queue!"<<std::endl;
   ++fMillislicesBuilt;
 
-  unsigned int nDropped = 0;
-
-  if (lastPacket == fPacketBuffer.begin()) {
-    fPacketBuffer.pop_front();
-    ++nDropped;
-  } else {
-    for (auto packetIter = (fPacketBuffer.begin())++; packetIter != lastPacket; ++packetIter) {
-      fPacketBuffer.pop_front();
-      ++nDropped;
-    }
-    fPacketBuffer.pop_front();
-    ++nDropped;
-  }
-
-  for (auto packetIter = eventsToPutBack.rbegin(); packetIter != eventsToPutBack.rend(); ++packetIter) {
-    fPacketBuffer.push_front(std::move(*packetIter));
-  }
-
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface BuildFragment complete.";
 }
 
@@ -622,52 +773,115 @@ dunedaq::sspmodules::DeviceInterface::ReadEventFromDevice(EventPacket& event)
 
   // TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface ReadEventFromDevice called.";
 
-  if (fState != kRunning) {
-    TLOG_DEBUG(TLVL_WORK_STEPS) << "Attempt to get data from non-running device refused!" << std::endl;
+  if (!this->ReadHeaderFromDevice(event.header)) {
     event.SetEmpty();
     return;
   }
 
-  std::vector<unsigned int> data;
+  // Wait for the full event body to be buffered
+  unsigned int bodyReadSize = event.header.length - headerSizeInWords;
+
+  if (!this->WaitForBufferedWords(bodyReadSize)) {
+    TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier()
+                                << "SSP delayed 10s between issuing header and full event; giving up" << std::endl;
+    event.DumpHeader();
+    event.SetEmpty();
+    throw(EEventReadError());
+  }
+
+  // Copy event data into event packet
+  event.data.resize(bodyReadSize);
+  fReadBuffer.Read(event.data.data(), bodyReadSize);
+
+  auto ehsize = sizeof(struct dunedaq::fddetdataformats::ssp::EventHeader);
+  auto ehlength = event.header.length;
+  TLOG_DEBUG(TLVL_WORK_STEPS) << "Event data size: " << event.data.size() << " ehsize: " << ehsize
+                              << " ehl: " << ehlength;
+
+  // event.DumpHeader();
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface ReadEventFromDevice complete.";
+
+  return;
+}
+
+bool
+dunedaq::sspmodules::DeviceInterface::ReadFrameFromDevice(dunedaq::fdreadoutlibs::types::SSPFrameTypeAdapter& frame)
+{
+
+  if (!this->ReadHeaderFromDevice(frame.header)) {
+    return false;
+  }
+
+  // Wait for the full event body to be buffered
+  unsigned int bodyReadSize = frame.header.length - headerSizeInWords;
+
+  if (!this->WaitForBufferedWords(bodyReadSize)) {
+    TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier()
+                                << "SSP delayed 10s between issuing header and full event; giving up" << std::endl;
+    throw(EEventReadError());
+  }
+
+  // Copy the payload straight into the frame, in bytes, keeping whatever fits
+  unsigned int bodyBytes = bodyReadSize * sizeof(unsigned int);
+  unsigned int copyBytes = std::min(bodyBytes, static_cast<unsigned int>(sizeof(frame.data)));
+  unsigned char* frameData = reinterpret_cast<unsigned char*>(frame.data); // NOLINT
+  fReadBuffer.PeekBytes(frameData, copyBytes);
+  std::memset(frameData + copyBytes, 0, sizeof(frame.data) - copyBytes);
+  fReadBuffer.Discard(bodyReadSize);
+
+  if (copyBytes < bodyBytes) {
+    ++fTruncatedFrames;
+    TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier() << "Warning: event of " << bodyBytes
+                                << " payload bytes truncated to frame size of " << sizeof(frame.data) << " bytes"
+                                << std::endl;
+  }
+
+  return true;
+}
+
+bool
+dunedaq::sspmodules::DeviceInterface::ReadHeaderFromDevice(dunedaq::fddetdataformats::ssp::EventHeader& header)
+{
+
+  if (fState != kRunning) {
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Attempt to get data from non-running device refused!" << std::endl;
+    return false;
+  }
 
   unsigned int skippedWords = 0;
   unsigned int firstSkippedWord = 0;
 
-  unsigned int queueLengthInUInts = 0;
-
   // Find first word in event header (0xAAAAAAAA)
   while (true) {
 
-    fDevice->DeviceQueueStatus(&queueLengthInUInts);
-    data.clear();
-    if (queueLengthInUInts) {
-      fDevice->DeviceReceive(data, 1);
+    // Pull everything the device has queued into the read buffer in one go
+    if (!fReadBuffer.Size()) {
+      fReadBuffer.Fill(fDevice);
     }
 
     // If no data is available in pipe then return
-    // without filling packet
-    if (data.size() == 0) {
+    // without filling header
+    if (!fReadBuffer.Size()) {
       if (skippedWords) {
         TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier() << "Warning: GetEvent skipped " << skippedWords
                                     << "words and has not seen header for next event!" << std::endl;
       }
-      event.SetEmpty();
-      return;
+      return false;
     }
 
     // Header found - continue reading rest of event
-    if (data[0] == 0xAAAAAAAA) {
+    unsigned int word = fReadBuffer.Peek();
+    if (word == 0xAAAAAAAA) {
       break;
     }
     // Unexpected non-header word found - continue to
     // look for header word but need to issue warning
-    if (data.size() > 0) {
-      if (!skippedWords)
-        firstSkippedWord = data[0];
-      ++skippedWords;
-      TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier() << "Warning: GetEvent skipping over word " << data[0] << " (0x"
-                                  << std::hex << data[0] << std::dec << ")" << std::endl;
-    }
+    if (!skippedWords)
+      firstSkippedWord = word;
+    ++skippedWords;
+    TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier() << "Warning: GetEvent skipping over word " << word << " (0x"
+                                << std::hex << word << std::dec << ")" << std::endl;
+    fReadBuffer.Discard(1);
   }
 
   if (skippedWords) {
@@ -676,107 +890,146 @@ dunedaq::sspmodules::DeviceInterface::ReadEventFromDevice(EventPacket& event)
                                 << "First skipped word was 0x" << std::hex << firstSkippedWord << std::dec << std::endl;
   }
 
-  unsigned int* headerBlock = (unsigned int*)&event.header;
-  headerBlock[0] = 0xAAAAAAAA;
-
-  static const unsigned int headerReadSize = (sizeof(dunedaq::fddetdataformats::ssp::EventHeader) / sizeof(unsigned int) - 1);
-
-  // Wait for hardware queue to fill with full header data
-  unsigned int timeWaited = 0; // in us
-
-  do {
-    fDevice->DeviceQueueStatus(&queueLengthInUInts);
-    if (queueLengthInUInts < headerReadSize) {
-      usleep(100); // 100us
-      TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier()
-                                  << "Warning: we slept after finding pattern word while waiting for header."
-                                  << std::endl;
-
-      timeWaited += 100;
-      if (timeWaited > 10000000) { // 10s
-        TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier()
-                                    << "SSP delayed 10s between issuing header word and full header; giving up"
-                                    << std::endl;
-        event.SetEmpty();
-        throw(EEventReadError());
-      }
-    }
-  } while (queueLengthInUInts < headerReadSize);
-
-  // Get header from device and check it is the right length
-  fDevice->DeviceReceive(data, headerReadSize);
-  if (data.size() != headerReadSize) {
+  // Wait for the full header to be buffered
+  if (!this->WaitForBufferedWords(headerSizeInWords)) {
     TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier()
-                                << "SSP returned truncated header even though FIFO queue is of sufficient length!"
+                                << "SSP delayed 10s between issuing header word and full header; giving up"
                                 << std::endl;
-    event.SetEmpty();
     throw(EEventReadError());
   }
 
-  // Copy header into event packet
-  std::copy(data.begin(), data.end(), &(headerBlock[1]));
-
-  // Wait for hardware queue to fill with full event data
-  unsigned int bodyReadSize = event.header.length - (sizeof(dunedaq::fddetdataformats::ssp::EventHeader) / sizeof(unsigned int));
-  queueLengthInUInts = 0;
-  timeWaited = 0; // in us
-
-  do {
-    fDevice->DeviceQueueStatus(&queueLengthInUInts);
-    if (queueLengthInUInts < bodyReadSize) {
-      usleep(100); // 100us
-      TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier()
-                                  << "Warning: we slept after finding header before reading full event." << std::endl;
-      timeWaited += 100;
-      if (timeWaited > 10000000) { // 10s
-        TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier()
-                                    << "SSP delayed 10s between issuing header and full event; giving up" << std::endl;
-        event.DumpHeader();
-        event.SetEmpty();
-        throw(EEventReadError());
-      }
-    }
-  } while (queueLengthInUInts < bodyReadSize);
-
-  // Get event from SSP and check that it is the right length
-  fDevice->DeviceReceive(data, bodyReadSize);
+  // Copy header out of the read buffer
+  fReadBuffer.Read(reinterpret_cast<unsigned int*>(&header), headerSizeInWords); // NOLINT
 
-  if (data.size() != bodyReadSize) {
-    TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier()
-                                << "SSP returned truncated event even though FIFO queue is of sufficient length!"
-                                << std::endl;
-    event.SetEmpty();
+  if (header.length < headerSizeInWords) {
+    TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier() << "SSP returned event header with impossible length "
+                                << header.length << "!" << std::endl;
     throw(EEventReadError());
   }
 
-  // Copy event data into event packet
-  event.data = std::move(data);
-
-  auto ehsize = sizeof(struct dunedaq::fddetdataformats::ssp::EventHeader);
-  auto ehlength = event.header.length;
-  TLOG_DEBUG(TLVL_WORK_STEPS) << "Event data size: " << event.data.size() << " ehsize: " << ehsize
-                              << " ehl: " << ehlength;
+  return true;
+} // NOLINT(readability/fn_size)
 
-  // event.DumpHeader();
-  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface ReadEventFromDevice complete.";
+bool
+dunedaq::sspmodules::DeviceInterface::WaitForBufferedWords(unsigned int nWords)
+{
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
 
-  return;
-} // NOLINT(readability/fn_size)
+  while (fReadBuffer.Size() < nWords) {
+    if (fReadBuffer.Fill(fDevice)) {
+      continue;
+    }
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    fPollStrategy.Wait(fDevice, nWords - fReadBuffer.Size(), 1000);
+    TLOG_DEBUG(TLVL_WORK_STEPS) << this->GetIdentifier() << "Warning: we waited for " << nWords
+                                << " words of event data." << std::endl;
+  }
+  return true;
+}
 
 void
 dunedaq::sspmodules::DeviceInterface::Shutdown()
 {
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface Shutdown called.";
 
+  {
+    std::lock_guard<std::mutex> lock(fSlowControlMutex);
+    if (fSlowControlDevice && fSlowControlDevice != fDevice) {
+      fSlowControlDevice->Close();
+    }
+    fSlowControlDevice = 0;
+  }
   fDevice->Close();
   fState = kUninitialized;
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << "SSP Device Interface Shutdown complete.";
 }
 
+dunedaq::sspmodules::DeviceInterface::WriteBatch::WriteBatch(DeviceInterface& iface)
+  : fInterface(iface)
+  , fOpen(true)
+{
+  ++fInterface.fWriteBatchDepth;
+}
+
+dunedaq::sspmodules::DeviceInterface::WriteBatch::~WriteBatch()
+{
+  if (!fOpen) {
+    return;
+  }
+  // An inner batch leaves its writes to the outer one
+  if (--fInterface.fWriteBatchDepth || fInterface.fPendingWrites.empty()) {
+    return;
+  }
+  TLOG() << fInterface.GetIdentifier() << "Warning: write batch left uncommitted, dropping "
+         << fInterface.fPendingWrites.size() << " register writes";
+  fInterface.fPendingWrites.clear();
+}
+
+void
+dunedaq::sspmodules::DeviceInterface::WriteBatch::Commit()
+{
+  if (!fOpen) {
+    return;
+  }
+  fOpen = false;
+  if (--fInterface.fWriteBatchDepth) {
+    return;
+  }
+  fInterface.FlushWriteBatch();
+}
+
+void
+dunedaq::sspmodules::DeviceInterface::FlushWriteBatch()
+{
+  static const unsigned int maxArraySize =
+    sizeof(dunedaq::fddetdataformats::ssp::CtrlPacket::data) / sizeof(unsigned int);
+
+  std::vector<std::pair<unsigned int, unsigned int>> singleWrites;
+  std::vector<unsigned int> runValues;
+
+  // Take the pending writes out first so a device error leaves the batch empty
+  std::map<unsigned int, unsigned int> pending;
+  pending.swap(fPendingWrites);
+
+  auto write = pending.begin();
+  while (write != pending.end()) {
+    unsigned int runStart = write->first;
+    runValues.clear();
+    do {
+      runValues.push_back(write->second);
+      ++write;
+    } while (write != pending.end() && write->first == runStart + 4 * runValues.size() &&
+             runValues.size() < maxArraySize);
+
+    if (runValues.size() > 1) {
+      TLOG_DEBUG(TLVL_FULL_DEBUG) << "Write batch sending " << runValues.size() << " registers from 0x" << std::hex
+                                  << runStart << std::dec << " as one array write" << std::endl;
+      fDevice->DeviceArrayWrite(runStart, runValues.size(), runValues.data());
+    } else {
+      singleWrites.emplace_back(runStart, runValues[0]);
+    }
+  }
+
+  if (!singleWrites.empty()) {
+    fDevice->DeviceWriteList(singleWrites);
+  }
+}
+
 void
 dunedaq::sspmodules::DeviceInterface::SetRegister(unsigned int address, unsigned int value, unsigned int mask)
 {
 
+  if (fWriteBatchDepth) {
+    if (mask == 0xFFFFFFFF) {
+      fPendingWrites[address] = value;
+      return;
+    }
+    // Masked writes need the hardware value, so send what we have so far first
+    this->FlushWriteBatch();
+  }
+
   if (mask == 0xFFFFFFFF) {
     fDevice->DeviceWrite(address, value);
   } else {
@@ -795,6 +1048,13 @@ void
 dunedaq::sspmodules::DeviceInterface::SetRegisterArray(unsigned int address, unsigned int* value, unsigned int size)
 {
 
+  if (fWriteBatchDepth) {
+    for (unsigned int i = 0; i < size; ++i) {
+      fPendingWrites[address + 4 * i] = value[i];
+    }
+    return;
+  }
+
   fDevice->DeviceArrayWrite(address, size, value);
 }
 
@@ -802,6 +1062,11 @@ void
 dunedaq::sspmodules::DeviceInterface::ReadRegister(unsigned int address, unsigned int& value, unsigned int mask)
 {
 
+  if (fWriteBatchDepth) {
+    // Reads see the writes made so far, so send them first
+    this->FlushWriteBatch();
+  }
+
   if (mask == 0xFFFFFFFF) {
     fDevice->DeviceRead(address, &value);
   } else {
@@ -809,6 +1074,17 @@ dunedaq::sspmodules::DeviceInterface::ReadRegister(unsigned int address, unsigne
   }
 }
 
+void
+dunedaq::sspmodules::DeviceInterface::RefreshRegister(unsigned int address, unsigned int& value)
+{
+
+  if (fWriteBatchDepth) {
+    this->FlushWriteBatch();
+  }
+
+  fDevice->DeviceReadForced(address, &value);
+}
+
 void
 dunedaq::sspmodules::DeviceInterface::ReadRegisterArray(unsigned int address,
                                                         std::vector<unsigned int>& value,
@@ -823,8 +1099,60 @@ void
 dunedaq::sspmodules::DeviceInterface::ReadRegisterArray(unsigned int address, unsigned int* value, unsigned int size)
 {
 
+  if (fWriteBatchDepth) {
+    this->FlushWriteBatch();
+  }
+
   fDevice->DeviceArrayRead(address, size, value);
 }
+void
+dunedaq::sspmodules::DeviceInterface::ReadMonitorRegister(unsigned int address, unsigned int& value)
+{
+  std::lock_guard<std::mutex> lock(fSlowControlMutex);
+  if (fSlowControlDevice) {
+    fSlowControlDevice->DeviceRead(address, &value);
+  } else {
+    fDevice->DeviceRead(address, &value);
+  }
+}
+
+void
+dunedaq::sspmodules::DeviceInterface::ReadMonitorRegisterByName(std::string name, unsigned int& value)
+{
+  dunedaq::sspmodules::RegMap::Register reg = (dunedaq::sspmodules::RegMap::Get())[name];
+
+  this->ReadMonitorRegister(reg, value);
+  value &= reg.ReadMask();
+}
+
+void
+dunedaq::sspmodules::DeviceInterface::ReadMonitorRegisterArrayByName(std::string name,
+                                                                     std::vector<unsigned int>& values)
+{
+  dunedaq::sspmodules::RegMap::Register reg = (dunedaq::sspmodules::RegMap::Get())[name];
+
+  values.resize(reg.Size());
+  std::lock_guard<std::mutex> lock(fSlowControlMutex);
+  Device* device = fSlowControlDevice ? fSlowControlDevice : fDevice;
+  device->DeviceArrayRead(reg[0], reg.Size(), values.data());
+  for (auto value = values.begin(); value != values.end(); ++value) {
+    *value &= reg.ReadMask();
+  }
+}
+
+void
+dunedaq::sspmodules::DeviceInterface::DumpDeviceStats(std::ostream& os)
+{
+  if (fDevice) {
+    fDevice->Stats().Dump(os);
+  }
+  std::lock_guard<std::mutex> lock(fSlowControlMutex);
+  if (fSlowControlDevice && fSlowControlDevice != fDevice) {
+    os << "Slow control session:" << std::endl;
+    fSlowControlDevice->Stats().Dump(os);
+  }
+}
+
 void
 dunedaq::sspmodules::DeviceInterface::SetRegisterByName(std::string name, unsigned int value)
 {
@@ -898,6 +1226,11 @@ dunedaq::sspmodules::DeviceInterface::ConfigureLEDCalib(const nlohmann::json& ar
     return;
   }
 
+  // Configuration is always sent in full, whatever we think the board holds
+  if (fDevice) {
+    fDevice->DeviceInvalidateCache();
+  }
+
   auto m_cfg = args.get<dunedaq::sspmodules::sspledcalibmodule::Conf>();
   int interfaceTypeCode = m_cfg.interface_type; // dunedaq::detdataformats::kEthernet;
   std::stringstream ss;
@@ -921,7 +1254,11 @@ dunedaq::sspmodules::DeviceInterface::ConfigureLEDCalib(const nlohmann::json& ar
       throw ConfigurationError(ERS_HERE, ss.str());
   }
   //
-  if (fCommType != dunedaq::fddetdataformats::ssp::kEthernet) {
+  if (fCommType == dunedaq::fddetdataformats::ssp::kEmulated) {
+    // Emulated boards are numbered by board ID, so several can run in one process
+    fDeviceId = m_cfg.board_id;
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Using emulated board " << fDeviceId << std::endl;
+  } else if (fCommType != dunedaq::fddetdataformats::ssp::kEthernet) {
     fDeviceId = 0;
     std::stringstream ss;
     ss << "Error: Non-functioning interface type set: " << fCommType
@@ -931,26 +1268,39 @@ dunedaq::sspmodules::DeviceInterface::ConfigureLEDCalib(const nlohmann::json& ar
   } else {
     TLOG_DEBUG(TLVL_WORK_STEPS) << "Board IP is listed as: " << m_cfg.board_ip << std::endl;
     fDeviceId = inet_network(m_cfg.board_ip.c_str()); // inet_network("10.73.137.56");
-  }
 
-  // Ask device manager for a pointer to the specified device
-  dunedaq::sspmodules::DeviceManager& devman = dunedaq::sspmodules::DeviceManager::Get();
-  dunedaq::sspmodules::Device* device = 0;
-
-  TLOG_DEBUG(TLVL_WORK_STEPS) << "Configuring "
-                              << ((fCommType == dunedaq::fddetdataformats::ssp::kUSB)
-                                    ? "USB"
-                                    : ((fCommType == dunedaq::fddetdataformats::ssp::kEthernet) ? "Ethernet" : "Emulated"))
-                              << " device #" << fDeviceId << "..." << std::endl;
+    dunedaq::sspmodules::EthernetDevice::SocketOptions socketOptions;
+    socketOptions.receiveBufferSize = m_cfg.socket_receive_buffer;
+    socketOptions.sendBufferSize = m_cfg.socket_send_buffer;
+    socketOptions.controlNoDelay = m_cfg.control_nodelay;
+    socketOptions.busyPollInUs = m_cfg.busy_poll_us;
+    socketOptions.busyPollRead = m_cfg.busy_poll_read;
+    dunedaq::sspmodules::DeviceManager::Get().SetSocketOptions(fDeviceId, socketOptions);
+
+    dunedaq::sspmodules::EthernetDevice::ControlOptions controlOptions;
+    controlOptions.maxInFlight = m_cfg.max_in_flight;
+    controlOptions.transactionTimeoutInMs = m_cfg.transaction_timeout_ms;
+    controlOptions.initialBackoffInMs = m_cfg.retry_backoff_ms;
+    controlOptions.maxBackoffInMs = m_cfg.retry_max_backoff_ms;
+    controlOptions.purgeQuiescenceInMs = m_cfg.purge_quiescence_ms;
+    dunedaq::sspmodules::DeviceManager::Get().SetControlOptions(fDeviceId, controlOptions);
+  }
 
-  device = devman.OpenDevice(fCommType, fDeviceId);
+  this->Open();
+  fDevice->ResetStats();
 
-  if (!device) {
-    TLOG_DEBUG(TLVL_WORK_STEPS) << "Unable to get handle to device; giving up!" << std::endl;
-    throw(ENoSuchDevice());
+  auto ethernetDevice = dynamic_cast<dunedaq::sspmodules::EthernetDevice*>(fDevice);
+  if (ethernetDevice) {
+    const dunedaq::sspmodules::EthernetDevice::SocketOptions& effective = ethernetDevice->EffectiveSocketOptions();
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Socket options in effect: SO_RCVBUF " << effective.receiveBufferSize
+                                << ", SO_SNDBUF " << effective.sendBufferSize << ", control TCP_NODELAY "
+                                << effective.controlNoDelay << ", SO_BUSY_POLL " << effective.busyPollInUs
+                                << " us, busy-poll reads " << effective.busyPollRead << std::endl;
   }
 
-  fDevice = device;
+  if (m_cfg.slow_control_session) {
+    this->OpenSlowControlSession();
+  }
 
   // Reset timing endpoint
   dunedaq::sspmodules::RegMap& duneReg = dunedaq::sspmodules::RegMap::Get();
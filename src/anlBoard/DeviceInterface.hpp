@@ -17,13 +17,22 @@
 #include "DeviceManager.hpp"
 #include "Device.hpp"
 #include "SafeQueue.hpp"
+#include "SPSCRing.hpp"
 #include "EventPacket.hpp"
-
+#include "FragmentBufferPool.hpp"
+#include "CoincidenceEngine.hpp"
+#include "DeviceReadBuffer.hpp"
+#include "PacketBuffer.hpp"
+#include "PollStrategy.hpp"
+
+#include <array>
+#include <functional>
+#include <ostream>
 #include <string>
 #include <memory>
 #include <map>
-#include <deque>
 #include <queue>
+#include <utility>
 #include <vector>
 
 namespace dunedaq {
@@ -42,7 +51,11 @@ public:
 
   // RS: queues here... I know...
   using sink_t = dunedaq::iomanager::SenderConcept<dunedaq::fdreadoutlibs::types::SSPFrameTypeAdapter>;
-  std::map<unsigned, std::shared_ptr<sink_t>> m_sink_queues;
+
+  //One sink per hardware channel, indexed by the channel ID in the event header.
+  //Filled in Initialize; channels with no queue configured are left null.
+  static constexpr unsigned int kNChannels = 16;
+  std::array<std::shared_ptr<sink_t>, kNChannels> m_sink_queues;
 
 
   enum State_t{kUninitialized,kInitialized,kRunning,kStopping,kStopped,kBad};
@@ -59,6 +72,18 @@ public:
 
   void OpenSlowControl();
 
+  //Get the device from the device manager for data taking, without configuring
+  //it. ConfigureLEDCalib does this itself; test code driving an emulated board
+  //can call it directly, followed by Stop() to put the hardware in a known state.
+  void Open();
+
+  //Open a second connection to the board for slow control alone (port 55002
+  //on Ethernet), to carry the monitoring reads below. Call after Open.
+  void OpenSlowControlSession();
+
+  //Whether a slow control session is open, so monitoring reads are safe from any thread
+  bool HasSlowControlSession();
+
   //Does all the real work in connecting to and setting up the device
   void Initialize(const nlohmann::json& args);
 
@@ -84,20 +109,83 @@ public:
   //void Configure(const nlohmann::json& args);
   void ConfigureLEDCalib(const nlohmann::json& args);
 
-  //Generate fragment from the data available on the buffer, if possible
+  //Generate fragment from the data available on the buffer, if possible.
+  //If fragment is too small to hold it, its storage is swapped for a buffer
+  //from FragmentPool(); hand fragments back there once done with them.
   void ReadEvent(std::vector<unsigned int>& fragment);
 
-  //Actually read from the hardware. Thread spawned here at Start
+  //Buffers for ReadEvent to build fragments into
+  inline FragmentBufferPool& FragmentPool(){return fFragmentPool;}
+
+  //Actually read from the hardware. Thread spawned here at Start.
+  //Events are decoded into frames in fFrameRing and sent on by DispatchLoop,
+  //so a slow downstream consumer does not hold up draining the device.
   void HardwareReadLoop();
 
+  //Send frames from fFrameRing to the sink queues. Thread spawned here at Start
+  void DispatchLoop();
+
+  //Called from the dispatch thread with each frame just before it is sent on
+  //(or dropped, if its channel has no sink queue). Only set while stopped.
+  using DispatchCallback = std::function<void(const dunedaq::fdreadoutlibs::types::SSPFrameTypeAdapter&)>;
+  void SetDispatchCallback(DispatchCallback callback){fDispatchCallback = std::move(callback);}
+
+  //Ring between the read and dispatch threads, for fill level/overrun counters
+  inline const SPSCRing<dunedaq::fdreadoutlibs::types::SSPFrameTypeAdapter>& FrameRing() const{return fFrameRing;}
+
+  //Number of events this run whose payload did not fit in a frame
+  inline unsigned long TruncatedFrames() const{return fTruncatedFrames;}  // NOLINT(runtime/int)
+
+  //Number of frames this run for channels with no sink queue configured
+  inline unsigned long UnroutedFrames() const{return fUnroutedFrames;}  // NOLINT(runtime/int)
+
   //Called by ReadEvents
   //Get an event off the hardware buffer.
   //Timeout after some wait period
   void ReadEventFromDevice(EventPacket& event);
 
+  //Packets waiting for triggers, for its footprint and eviction counters
+  inline const PacketBuffer& GetPacketBuffer() const{return fPacketBuffer;}
+
+  //Triggers thrown away because too many were already waiting
+  inline unsigned long DroppedTriggers() const{return fDroppedTriggers;}  // NOLINT(runtime/int)
+
+  //As ReadEventFromDevice, but decode directly into a frame for the sink queues.
+  //Payload beyond the size of the frame is dropped. Returns false if no event
+  //was available.
+  bool ReadFrameFromDevice(dunedaq::fdreadoutlibs::types::SSPFrameTypeAdapter& frame);
+
   //Obtain current state of device
   inline State_t State(){return fState;}
 
+  //Device opened by Open/ConfigureLEDCalib/OpenSlowControl, or null.
+  //Owned by the device manager.
+  inline Device* GetDevice(){return fDevice;}
+
+  //Collects register writes made through SetRegister and SetRegisterArray
+  //while in scope, and sends them on Commit(): sorted by address, with
+  //contiguous runs going out as one DeviceArrayWrite and the rest as one
+  //DeviceWriteList. Writes to the same address collapse to the last value.
+  //Only use around writes whose relative order does not matter to the hardware.
+  //A register read or masked write made inside a batch first sends the writes
+  //pending so far, so it sees them.
+  //Batches may be nested; committing the outermost one sends.
+  class WriteBatch{
+  public:
+    explicit WriteBatch(DeviceInterface& iface);
+    //An outermost batch going out of scope uncommitted (e.g. on an exception)
+    //drops its pending writes, logging how many there were
+    ~WriteBatch();
+    WriteBatch(const WriteBatch&) = delete;
+    WriteBatch& operator=(const WriteBatch&) = delete;
+    //Close the batch, sending the pending writes if it is the outermost one.
+    //Throws as the device does; the writes are dropped either way.
+    void Commit();
+  private:
+    DeviceInterface& fInterface;
+    bool fOpen;
+  };
+
   //Setter for single register
   //If mask is given then only bits which are high in the mask will be set.
   void SetRegister(unsigned int address, unsigned int value, unsigned int mask=0xFFFFFFFF);
@@ -112,12 +200,32 @@ public:
   //If mask is set then bits which are low in the mask will be returned as zeros.
   void ReadRegister(unsigned int address, unsigned int& value, unsigned int mask=0xFFFFFFFF);
 
+  //Getter for single register which always goes to the hardware, for when the
+  //device may be answering reads of configuration registers from its cache
+  void RefreshRegister(unsigned int address, unsigned int& value);
+
   //Getter for series of contiguous registers, with vector output
   void ReadRegisterArray(unsigned int address, std::vector<unsigned int>& value, unsigned int size);
 
   //Getter for series of contiguous registers, with C array output
   void ReadRegisterArray(unsigned int address, unsigned int* value, unsigned int size);
 
+  //Register reads for monitoring the board, e.g. bias_readback, pdts_status or
+  //live_timestamp_*. With a slow control session open these can be called from
+  //any thread while a run is going, since they never share a socket or lock with
+  //the readout or run control. Without one they go over the main connection, so
+  //only call them from the thread which does the other register access.
+  void ReadMonitorRegister(unsigned int address, unsigned int& value);
+
+  void ReadMonitorRegisterByName(std::string name, unsigned int& value);
+
+  void ReadMonitorRegisterArrayByName(std::string name, std::vector<unsigned int>& values);
+
+  //Write out the call counts and latency histograms of the device operations
+  //since the last configure, for the main connection and any slow control
+  //session. Counters can be read from GetDevice()->Stats() directly.
+  void DumpDeviceStats(std::ostream& os);
+
   //Methods to set registers with names (as defined in SSPDAQ::RegMap)
 
   //Set single named register
@@ -153,16 +261,37 @@ public:
 
   void SetDummyPeriod(int period){fDummyPeriod=period;}
 
+  //Bound the memory held for packets waiting on triggers, by bytes and by
+  //ticks between oldest and newest packet (0 for no limit). The oldest
+  //packets are evicted first.
+  void SetPacketBufferLimits(unsigned long maxBytes, unsigned long maxSpan){fPacketBuffer.SetLimits(maxBytes, maxSpan);}  // NOLINT(runtime/int)
+
+  //Most triggers to hold waiting to be built; the oldest is dropped beyond this
+  void SetMaxPendingTriggers(unsigned int val){fMaxPendingTriggers=val;}
+
   void SetUseExternalTimestamp(bool val){fUseExternalTimestamp = val;}
 
   void SetTriggerMask(unsigned int val){fTriggerMask=val;}
 
+  //Number of channels on the board (5 or 12), for trigger coincidences
+  void SetNChannels(unsigned int val){fCoincidence.SetNChannels(val);}
+
+  //Triggering packets on different channels within this many ticks of each
+  //other make up one trigger
+  void SetCoincidenceWindow(unsigned long ticks){fCoincidence.SetWindow(ticks);}  // NOLINT(runtime/int)
+
   void SetFragmentTimestampOffset(int val){fFragmentTimestampOffset=val;}
 
   void SetPartitionNumber(unsigned int val){fPartitionNumber=val;}
 
   void SetTimingAddress(unsigned int val){fTimingAddress=val;}
 
+  //Receive from the data channel asynchronously while running, if the device supports it
+  void SetAsyncReceive(bool val){fAsyncReceive=val;}
+
+  //How the read thread waits when the board has no data for it
+  void SetPollStrategy(const PollStrategy::Settings& settings){fPollStrategy.Configure(settings);}
+
   void PrintHardwareState();
 
   std::string GetIdentifier();
@@ -175,6 +304,13 @@ private:
   //Owned by the device manager, not this object.
   Device* fDevice;
 
+  //Slow control session used for monitoring reads, or null if there is none.
+  //Owned by the device manager. Emulated boards hand back fDevice itself.
+  Device* fSlowControlDevice;
+
+  //Serialises monitoring reads from different threads
+  std::mutex fSlowControlMutex;
+
   //Whether we are using USB or Ethernet to connect to the device
   dunedaq::fddetdataformats::ssp::Comm_t fCommType;
 
@@ -189,8 +325,22 @@ private:
   //Build millislice from events in buffer and place in fQueue
   void BuildFragment(const TriggerInfo& theTrigger,std::vector<unsigned int>& fragmentData);
 
+  //Find the next event header in the data stream and read it out.
+  //Returns false if no event was available.
+  bool ReadHeaderFromDevice(dunedaq::fddetdataformats::ssp::EventHeader& header);
+
+  //Keep filling the read buffer until it holds at least nWords.
+  //Returns false if the device has not delivered them within 10s.
+  bool WaitForBufferedWords(unsigned int nWords);
+
+  //Send everything collected by the current WriteBatch
+  void FlushWriteBatch();
+
   bool GetTriggerInfo(const EventPacket& event,dunedaq::sspmodules::TriggerInfo& newTrigger);
 
+  //Add a trigger to fTriggers, dropping the oldest if fMaxPendingTriggers are waiting
+  void QueueTrigger(const TriggerInfo& trigger);
+
   unsigned long GetTimestamp(const dunedaq::fddetdataformats::ssp::EventHeader& header);  // NOLINT(runtime/int)
 
   void SetExternalTimestamp(dunedaq::fddetdataformats::ssp::EventHeader& header, unsigned long newtimestamp);  // NOLINT(runtime/int)
@@ -206,7 +356,23 @@ private:
 
   void set_exception( bool exception ) { exception_.store( exception ); }
 
-  std::deque<EventPacket> fPacketBuffer;
+  //Nesting depth of WriteBatch scopes, and the writes they have collected
+  unsigned int fWriteBatchDepth;
+
+  std::map<unsigned int, unsigned int> fPendingWrites;
+
+  bool fAsyncReceive;
+
+  //Words received from the data channel but not yet parsed into events
+  DeviceReadBuffer fReadBuffer;
+
+  //Used by the read thread to wait for more data
+  PollStrategy fPollStrategy;
+
+  //Events waiting for a trigger to build them into a fragment
+  PacketBuffer fPacketBuffer;
+
+  FragmentBufferPool fFragmentPool;
 
   unsigned long fMillislicesSent;   // NOLINT(runtime/int)
 
@@ -240,12 +406,35 @@ private:
 
   std::queue<TriggerInfo> fTriggers;
 
+  unsigned int fMaxPendingTriggers;
+
+  std::atomic<unsigned long> fDroppedTriggers;  // NOLINT(runtime/int)
+
+  //Open trigger windows, for GetTriggerInfo
+  CoincidenceEngine fCoincidence;
+
   std::atomic<bool> exception_;
 
   std::atomic<bool> fShouldStop;
 
   std::thread* fDataThread;
 
+  std::atomic<bool> fDispatchShouldStop;
+
+  std::thread* fDispatchThread;
+
+  //Preallocated frames between the read and dispatch threads
+  SPSCRing<dunedaq::fdreadoutlibs::types::SSPFrameTypeAdapter> fFrameRing;
+
+  //Scratch frame for data read while the ring is full
+  dunedaq::fdreadoutlibs::types::SSPFrameTypeAdapter fOverrunFrame;
+
+  std::atomic<unsigned long> fTruncatedFrames;  // NOLINT(runtime/int)
+
+  std::atomic<unsigned long> fUnroutedFrames;  // NOLINT(runtime/int)
+
+  DispatchCallback fDispatchCallback;
+
   //RequestReceiver* fRequestReceiver;
 
   std::mutex fBufferMutex;
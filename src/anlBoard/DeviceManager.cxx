@@ -20,12 +20,15 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <exception>
+#include <future>
 #include <iomanip>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <unistd.h>
 #include <utility>
+#include <vector>
 
 dunedaq::sspmodules::DeviceManager&
 dunedaq::sspmodules::DeviceManager::Get()
@@ -34,7 +37,9 @@ dunedaq::sspmodules::DeviceManager::Get()
   return instance;
 }
 
-dunedaq::sspmodules::DeviceManager::DeviceManager() {}
+dunedaq::sspmodules::DeviceManager::DeviceManager()
+  : fHaveLookedForDevices(false)
+{}
 
 //
 // unsigned int SSPDAQ::DeviceManager::GetNUSBDevices(){
@@ -56,23 +61,12 @@ dunedaq::sspmodules::DeviceManager::RefreshDevices()
   //    }
   //  }
   //
-  for (auto device = fEthernetDevices.begin(); device != fEthernetDevices.end(); ++device) {
-    if ((device->second)->IsOpen()) {
-      // dune::DAQLogger::LogWarning("SSP_DeviceManager")<<"Device manager refused request to refresh device list"
-      //<<"due to ethernet devices still open"<<std::endl;
-    }
-  }
-  for (auto device = fEmulatedDevices.begin(); device != fEmulatedDevices.end(); ++device) {
-    if ((*device)->IsOpen()) {
-      // dune::DAQLogger::LogWarning("SSP_DeviceManager")<<"Device manager refused request to refresh device list"
-      //<<"due to emulated devices still open"<<std::endl;
-    }
-  }
+  std::lock_guard<std::mutex> lock(fMutex);
 
-  // Clear Device List
+  // Ethernet and emulated device objects used to be cleared here. Callers hold
+  // raw pointers to them (and Ethernet devices never report being open), so
+  // clearing them left those pointers dangling; they are now kept.
   // fUSBDevices.clear();
-  fEthernetDevices.clear();
-  fEmulatedDevices.clear();
 
   //
   //  //===========================//
@@ -172,6 +166,24 @@ dunedaq::sspmodules::DeviceManager::RefreshDevices()
   //
   //  delete[] deviceInfoNodes;
   //
+
+  fHaveLookedForDevices = true;
+}
+
+void
+dunedaq::sspmodules::DeviceManager::SetSocketOptions(unsigned long ipAddress,  // NOLINT(runtime/int)
+                                                     const EthernetDevice::SocketOptions& options)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  fSocketOptions[ipAddress] = options;
+}
+
+void
+dunedaq::sspmodules::DeviceManager::SetControlOptions(unsigned long ipAddress,  // NOLINT(runtime/int)
+                                                      const EthernetDevice::ControlOptions& options)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  fControlOptions[ipAddress] = options;
 }
 
 dunedaq::sspmodules::Device*
@@ -185,6 +197,7 @@ dunedaq::sspmodules::DeviceManager::OpenDevice(dunedaq::fddetdataformats::ssp::C
   }
 
   Device* device = 0;
+  std::unique_lock<std::mutex> lock(fMutex);
   switch (commType) {
       //
       //  case SSPDAQ::kUSB:
@@ -209,8 +222,15 @@ dunedaq::sspmodules::DeviceManager::OpenDevice(dunedaq::fddetdataformats::ssp::C
         // dune::DAQLogger::LogError("SSP_DeviceManager")<<"Attempt to open already open device!"<<std::endl;
         throw(EDeviceAlreadyOpen());
       } else {
+        if (fSocketOptions.find(deviceNum) != fSocketOptions.end()) {
+          fEthernetDevices[deviceNum]->SetSocketOptions(fSocketOptions[deviceNum]);
+        }
+        if (fControlOptions.find(deviceNum) != fControlOptions.end()) {
+          fEthernetDevices[deviceNum]->SetControlOptions(fControlOptions[deviceNum]);
+        }
         device = fEthernetDevices[deviceNum].get();
-        device->Open(slowControlOnly);
+        // Connecting can take a while, so let other callers in meanwhile
+        this->OpenUnlocked(device, slowControlOnly, lock);
       }
       break;
 
@@ -234,4 +254,95 @@ dunedaq::sspmodules::DeviceManager::OpenDevice(dunedaq::fddetdataformats::ssp::C
   return device;
 }
 
+dunedaq::sspmodules::Device*
+dunedaq::sspmodules::DeviceManager::OpenSlowControlSession(dunedaq::fddetdataformats::ssp::Comm_t commType,
+                                                           unsigned int deviceNum)
+{
+  if (commType != dunedaq::fddetdataformats::ssp::kEthernet) {
+    // Emulated devices are opened (or not) by OpenDevice as usual
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (commType != dunedaq::fddetdataformats::ssp::kEmulated || fEmulatedDevices.size() <= deviceNum) {
+      throw(ENoSuchDevice());
+    }
+    return fEmulatedDevices[deviceNum].get();
+  }
+
+  std::unique_lock<std::mutex> lock(fMutex);
+  std::unique_ptr<EthernetDevice>& session = fSlowControlSessions[deviceNum];
+  if (!session) {
+    session.reset(new dunedaq::sspmodules::EthernetDevice(deviceNum));
+  }
+  if (fSocketOptions.find(deviceNum) != fSocketOptions.end()) {
+    session->SetSocketOptions(fSocketOptions[deviceNum]);
+  }
+  if (fControlOptions.find(deviceNum) != fControlOptions.end()) {
+    session->SetControlOptions(fControlOptions[deviceNum]);
+  }
+  Device* device = session.get();
+  this->OpenUnlocked(device, true, lock);
+  return device;
+}
+
+void
+dunedaq::sspmodules::DeviceManager::OpenUnlocked(Device* device, bool slowControlOnly, std::unique_lock<std::mutex>& lock)
+{
+  if (fOpening.count(device)) {
+    throw(EDeviceAlreadyOpen());
+  }
+  fOpening.insert(device);
+  lock.unlock();
+  try {
+    device->Open(slowControlOnly);
+  } catch (...) {
+    lock.lock();
+    fOpening.erase(device);
+    throw;
+  }
+  lock.lock();
+  fOpening.erase(device);
+}
+
+std::vector<dunedaq::sspmodules::Device*>
+dunedaq::sspmodules::DeviceManager::OpenEthernetDevices(const std::vector<unsigned int>& ipAddresses,
+                                                        const std::function<void(Device*)>& configure,
+                                                        bool slowControlOnly)
+{
+  std::vector<std::future<Device*>> opens;
+  for (auto ipAddress = ipAddresses.begin(); ipAddress != ipAddresses.end(); ++ipAddress) {
+    opens.push_back(std::async(std::launch::async, [this, ipAddress, &configure, slowControlOnly] {
+      Device* device = this->OpenDevice(dunedaq::fddetdataformats::ssp::kEthernet, *ipAddress, slowControlOnly);
+      if (configure) {
+        try {
+          configure(device);
+        } catch (...) {
+          device->Close();
+          throw;
+        }
+      }
+      return device;
+    }));
+  }
+
+  // Wait for every attempt before reporting, so no thread outlives the call
+  std::vector<Device*> devices;
+  std::exception_ptr firstError;
+  for (auto open = opens.begin(); open != opens.end(); ++open) {
+    try {
+      devices.push_back(open->get());
+    } catch (...) {
+      if (!firstError) {
+        firstError = std::current_exception();
+      }
+    }
+  }
+
+  if (firstError) {
+    for (auto device = devices.begin(); device != devices.end(); ++device) {
+      (*device)->Close();
+    }
+    std::rethrow_exception(firstError);
+  }
+  return devices;
+}
+
 #endif // SSPMODULES_SRC_ANLBOARD_DEVICEMANAGER_CXX_
@@ -24,11 +24,16 @@
 #include <cstdio>
 #include <cstring>
 #include <unistd.h>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <set>
 
 namespace dunedaq {
 namespace sspmodules {
 
+//All methods may be called from several threads at once
 class DeviceManager{
 
 public:
@@ -41,8 +46,33 @@ public:
   //Open a device and return a pointer containing a handle to it
   Device* OpenDevice(dunedaq::fddetdataformats::ssp::Comm_t commType,unsigned int deviceId,bool slowControlOnly=false);
 
+  //Open a second, slow-control only connection to a board (port 55002 for
+  //Ethernet), separate from the device returned by OpenDevice, so register
+  //reads for monitoring never share its socket. Emulated devices answer
+  //register access under a lock of their own, so the device itself is returned.
+  Device* OpenSlowControlSession(dunedaq::fddetdataformats::ssp::Comm_t commType,unsigned int deviceId);
+
+  //Open the Ethernet boards at the given IP addresses all at once, each
+  //connecting from its own thread, so bringing up a crate takes about as long
+  //as its slowest board rather than the sum of them. Socket and control options are applied
+  //as for OpenDevice. If configure is given it is called on each board as soon as
+  //it is open, from the same thread, so that configuration overlaps too.
+  //If any board fails to open or configure the others are closed again, and the
+  //first error is rethrown once every attempt has finished.
+  std::vector<Device*> OpenEthernetDevices(const std::vector<unsigned int>& ipAddresses,
+                                           const std::function<void(Device*)>& configure=nullptr,
+                                           bool slowControlOnly=false);
+
+  //Socket tuning for the Ethernet device at ipAddress, used whenever it is next opened
+  void SetSocketOptions(unsigned long ipAddress, const EthernetDevice::SocketOptions& options);  // NOLINT(runtime/int)
+
+  //Control channel settings for the Ethernet device at ipAddress, used whenever it is next opened
+  void SetControlOptions(unsigned long ipAddress, const EthernetDevice::ControlOptions& options);  // NOLINT(runtime/int)
+
   //Interrogate FTDI for list of devices. GetNUSBDevices and OpenDevice will call this
   //if it has not yet been run, so it should not normally be necessary to call this directly.
+  //Ethernet and emulated devices are created on demand, so there is nothing to
+  //look for and existing device objects are kept.
   void RefreshDevices();
 
 private:
@@ -59,10 +89,30 @@ private:
   //Ethernet devices keyed by IP address
   std::map<unsigned long,std::unique_ptr<EthernetDevice> > fEthernetDevices;  // NOLINT(runtime/int)
 
+  //Socket options to apply to Ethernet devices when they are opened, keyed by IP address
+  std::map<unsigned long,EthernetDevice::SocketOptions> fSocketOptions;  // NOLINT(runtime/int)
+
+  //Control channel settings to apply to Ethernet devices when they are opened, keyed by IP address
+  std::map<unsigned long,EthernetDevice::ControlOptions> fControlOptions;  // NOLINT(runtime/int)
+
+  //Slow control sessions to Ethernet devices keyed by IP address
+  std::map<unsigned long,std::unique_ptr<EthernetDevice> > fSlowControlSessions;  // NOLINT(runtime/int)
+
   //List of emulated devices
   std::vector<std::unique_ptr<EmulatedDevice> > fEmulatedDevices;
 
-  bool fHaveLookedForDevices;
+  std::atomic<bool> fHaveLookedForDevices;
+
+  //Guards the device lists, fSocketOptions, fControlOptions and fOpening. Not held while a
+  //device connects, so that several boards can be opened at once.
+  std::mutex fMutex;
+
+  //Devices part way through Open
+  std::set<Device*> fOpening;
+
+  //Open a device with fMutex released for the duration, so other callers can
+  //get on meanwhile. lock must hold fMutex on entry, and holds it again on return.
+  void OpenUnlocked(Device* device,bool slowControlOnly,std::unique_lock<std::mutex>& lock);
 };
 
 } // namespace sspmodules
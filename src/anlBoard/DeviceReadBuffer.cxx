@@ -0,0 +1,84 @@
+/**
+ * @file DeviceReadBuffer.cxx
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_DEVICEREADBUFFER_CXX_
+#define SSPMODULES_SRC_ANLBOARD_DEVICEREADBUFFER_CXX_
+
+#include "DeviceReadBuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+dunedaq::sspmodules::DeviceReadBuffer::DeviceReadBuffer(unsigned int capacityInWords)
+  : fCapacity(1)
+  , fHead(0)
+  , fSize(0)
+{
+  while (fCapacity < capacityInWords) {
+    fCapacity <<= 1;
+  }
+  fMask = fCapacity - 1;
+  fBuffer.resize(fCapacity);
+}
+
+unsigned int
+dunedaq::sspmodules::DeviceReadBuffer::Fill(Device* device)
+{
+  unsigned int queueLengthInUInts = 0;
+  device->DeviceQueueStatus(&queueLengthInUInts);
+
+  unsigned int wordsToGet = std::min(queueLengthInUInts, this->Free());
+  if (wordsToGet == 0) {
+    return 0;
+  }
+
+  // Free space runs from the tail to the end of the buffer, then wraps to the start
+  unsigned int tail = (fHead + fSize) & fMask;
+  unsigned int firstChunk = std::min(wordsToGet, fCapacity - tail);
+  Device::ReceiveSegment segments[2] = { { fBuffer.data() + tail, firstChunk },
+                                         { fBuffer.data(), wordsToGet - firstChunk } };
+
+  unsigned int received = device->DeviceReceiveV(segments, segments[1].size ? 2 : 1);
+  fSize += received;
+
+  return received;
+}
+
+void
+dunedaq::sspmodules::DeviceReadBuffer::Read(unsigned int* dest, unsigned int size)
+{
+  unsigned int firstChunk = std::min(size, fCapacity - fHead);
+  std::copy(fBuffer.begin() + fHead, fBuffer.begin() + fHead + firstChunk, dest);
+  std::copy(fBuffer.begin(), fBuffer.begin() + (size - firstChunk), dest + firstChunk);
+  this->Discard(size);
+}
+
+void
+dunedaq::sspmodules::DeviceReadBuffer::PeekBytes(void* dest, unsigned int nBytes) const
+{
+  const unsigned int wordSize = sizeof(unsigned int);
+  unsigned int firstChunk = std::min(nBytes, (fCapacity - fHead) * wordSize);
+  std::memcpy(dest, fBuffer.data() + fHead, firstChunk);
+  std::memcpy(static_cast<unsigned char*>(dest) + firstChunk, fBuffer.data(), nBytes - firstChunk);
+}
+
+void
+dunedaq::sspmodules::DeviceReadBuffer::Discard(unsigned int size)
+{
+  fHead = (fHead + size) & fMask;
+  fSize -= size;
+}
+
+void
+dunedaq::sspmodules::DeviceReadBuffer::Clear()
+{
+  fHead = 0;
+  fSize = 0;
+}
+
+#endif // SSPMODULES_SRC_ANLBOARD_DEVICEREADBUFFER_CXX_
@@ -0,0 +1,80 @@
+/**
+ * @file DeviceReadBuffer.hpp
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_DEVICEREADBUFFER_HPP_
+#define SSPMODULES_SRC_ANLBOARD_DEVICEREADBUFFER_HPP_
+
+#include "Device.hpp"
+
+#include <vector>
+
+namespace dunedaq {
+namespace sspmodules {
+
+//Ring buffer sitting between the device data channel and the event parser.
+//Fill() pulls everything the device reports as queued straight into the free
+//space of the ring with a single DeviceReceiveV, and headers and bodies are
+//then parsed out of memory instead of asking the device for one word at a time.
+class DeviceReadBuffer{
+
+public:
+
+  //Capacity is rounded up to a power of two, and must hold at least one full
+  //SSP event (header length field is 16 bits, so 64k words).
+  explicit DeviceReadBuffer(unsigned int capacityInWords = 0x100000);
+
+  //Receive as much queued data as will fit into the buffer.
+  //Returns the number of words added.
+  unsigned int Fill(Device* device);
+
+  //Number of words currently buffered
+  inline unsigned int Size() const{
+    return fSize;
+  }
+
+  //Space left in the buffer, in words
+  inline unsigned int Free() const{
+    return fCapacity - fSize;
+  }
+
+  //Word at given offset from the read position, without consuming it.
+  //Offset must be less than Size().
+  inline unsigned int Peek(unsigned int offset = 0) const{
+    return fBuffer[(fHead + offset) & fMask];
+  }
+
+  //Copy size words into dest and remove them from the buffer
+  void Read(unsigned int* dest, unsigned int size);
+
+  //Copy the first nBytes of buffered data into dest without consuming it.
+  //nBytes must not exceed 4*Size().
+  void PeekBytes(void* dest, unsigned int nBytes) const;
+
+  //Remove size words from the buffer without copying them anywhere
+  void Discard(unsigned int size);
+
+  //Drop all buffered data
+  void Clear();
+
+private:
+
+  std::vector<unsigned int> fBuffer;
+
+  unsigned int fCapacity;
+
+  unsigned int fMask;
+
+  //Read position and number of buffered words
+  unsigned int fHead;
+
+  unsigned int fSize;
+};
+
+} // namespace sspmodules
+} // namespace dunedaq
+
+#endif // SSPMODULES_SRC_ANLBOARD_DEVICEREADBUFFER_HPP_
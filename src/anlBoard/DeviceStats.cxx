@@ -0,0 +1,173 @@
+/**
+ * @file DeviceStats.cxx
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_DEVICESTATS_CXX_
+#define SSPMODULES_SRC_ANLBOARD_DEVICESTATS_CXX_
+
+#include "DeviceStats.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+namespace {
+const char* const operationNames[] = { "DeviceRead",      "DeviceReadMask",  "DeviceReadForced", "DeviceWrite",
+                                       "DeviceWriteMask", "DeviceSet",       "DeviceClear",      "DeviceArrayRead",
+                                       "DeviceArrayWrite", "DeviceWriteList", "DeviceReceive",   "DeviceReceiveV",
+                                       "DeviceQueueStatus", "DeviceWaitForData", "DevicePurgeComm", "DevicePurgeData" };
+
+double
+bucket_upper_edge_us(unsigned int bucket)
+{
+  return static_cast<double>(2UL << bucket) / 1000.;
+}
+} // namespace
+
+dunedaq::sspmodules::DeviceStats::DeviceStats()
+{
+  this->Reset();
+}
+
+void
+dunedaq::sspmodules::DeviceStats::Record(Operation_t op, unsigned int address, std::chrono::nanoseconds elapsed)
+{
+  Cell& cell = fCells[op * kNRanges + (address >> 28)];
+  unsigned long ns = elapsed.count() > 0 ? elapsed.count() : 0; // NOLINT(runtime/int)
+
+  unsigned int bucket = ns ? 63 - __builtin_clzl(ns) : 0;
+  cell.buckets[std::min(bucket, kNBuckets - 1)].fetch_add(1, std::memory_order_relaxed);
+  cell.calls.fetch_add(1, std::memory_order_relaxed);
+  cell.totalNs.fetch_add(ns, std::memory_order_relaxed);
+
+  unsigned long previousMax = cell.maxNs.load(std::memory_order_relaxed); // NOLINT(runtime/int)
+  while (ns > previousMax && !cell.maxNs.compare_exchange_weak(previousMax, ns, std::memory_order_relaxed)) {
+  }
+}
+
+void
+dunedaq::sspmodules::DeviceStats::Accumulate(Operation_t op,
+                                             unsigned int firstRange,
+                                             unsigned int endRange,
+                                             unsigned long& calls,   // NOLINT(runtime/int)
+                                             unsigned long& totalNs, // NOLINT(runtime/int)
+                                             unsigned long& maxNs,   // NOLINT(runtime/int)
+                                             std::array<unsigned long, kNBuckets>& buckets) const // NOLINT(runtime/int)
+{
+  for (unsigned int range = firstRange; range < endRange; ++range) {
+    const Cell& cell = fCells[op * kNRanges + range];
+    calls += cell.calls.load(std::memory_order_relaxed);
+    totalNs += cell.totalNs.load(std::memory_order_relaxed);
+    maxNs = std::max(maxNs, cell.maxNs.load(std::memory_order_relaxed));
+    for (unsigned int i = 0; i < kNBuckets; ++i) {
+      buckets[i] += cell.buckets[i].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+dunedaq::sspmodules::DeviceStats::Summary
+dunedaq::sspmodules::DeviceStats::MakeSummary(unsigned long calls,   // NOLINT(runtime/int)
+                                              unsigned long totalNs, // NOLINT(runtime/int)
+                                              unsigned long maxNs,   // NOLINT(runtime/int)
+                                              const std::array<unsigned long, kNBuckets>& buckets) // NOLINT(runtime/int)
+{
+  Summary summary = { calls, 0., 0., 0., maxNs / 1000. };
+  if (!calls) {
+    return summary;
+  }
+  summary.meanInUs = totalNs / 1000. / calls;
+
+  // Counts are read one by one while other threads record, so the buckets may
+  // not quite add up to calls; go by their own total
+  unsigned long inBuckets = 0; // NOLINT(runtime/int)
+  for (unsigned int i = 0; i < kNBuckets; ++i) {
+    inBuckets += buckets[i];
+  }
+  unsigned long seen = 0; // NOLINT(runtime/int)
+  for (unsigned int i = 0; i < kNBuckets; ++i) {
+    seen += buckets[i];
+    if (!summary.p50InUs && seen * 2 >= inBuckets) {
+      summary.p50InUs = std::min(bucket_upper_edge_us(i), summary.maxInUs);
+    }
+    if (seen * 100 >= inBuckets * 99) {
+      summary.p99InUs = std::min(bucket_upper_edge_us(i), summary.maxInUs);
+      break;
+    }
+  }
+  return summary;
+}
+
+dunedaq::sspmodules::DeviceStats::Summary
+dunedaq::sspmodules::DeviceStats::Summarize(Operation_t op, unsigned int range) const
+{
+  unsigned long calls = 0;   // NOLINT(runtime/int)
+  unsigned long totalNs = 0; // NOLINT(runtime/int)
+  unsigned long maxNs = 0;   // NOLINT(runtime/int)
+  std::array<unsigned long, kNBuckets> buckets = {}; // NOLINT(runtime/int)
+
+  if (range >= kNRanges) {
+    this->Accumulate(op, 0, kNRanges, calls, totalNs, maxNs, buckets);
+  } else {
+    this->Accumulate(op, range, range + 1, calls, totalNs, maxNs, buckets);
+  }
+  return MakeSummary(calls, totalNs, maxNs, buckets);
+}
+
+dunedaq::sspmodules::DeviceStats::Summary
+dunedaq::sspmodules::DeviceStats::Summarize(const std::vector<Operation_t>& ops) const
+{
+  unsigned long calls = 0;   // NOLINT(runtime/int)
+  unsigned long totalNs = 0; // NOLINT(runtime/int)
+  unsigned long maxNs = 0;   // NOLINT(runtime/int)
+  std::array<unsigned long, kNBuckets> buckets = {}; // NOLINT(runtime/int)
+
+  for (auto op = ops.begin(); op != ops.end(); ++op) {
+    this->Accumulate(*op, 0, kNRanges, calls, totalNs, maxNs, buckets);
+  }
+  return MakeSummary(calls, totalNs, maxNs, buckets);
+}
+
+void
+dunedaq::sspmodules::DeviceStats::Dump(std::ostream& os) const
+{
+  os << std::left << std::setw(20) << "operation" << std::right << std::setw(12) << "address" << std::setw(12)
+     << "calls" << std::setw(12) << "mean/us" << std::setw(12) << "p50/us" << std::setw(12) << "p99/us"
+     << std::setw(12) << "max/us" << std::endl;
+
+  for (unsigned int op = 0; op < kNOperations; ++op) {
+    for (unsigned int range = 0; range < kNRanges; ++range) {
+      Summary summary = this->Summarize(static_cast<Operation_t>(op), range);
+      if (!summary.calls) {
+        continue;
+      }
+      os << std::left << std::setw(20) << operationNames[op] << std::right << "  0x" << std::hex << range
+         << "xxxxxxx" << std::dec << std::setw(12) << summary.calls << std::fixed << std::setprecision(1)
+         << std::setw(12) << summary.meanInUs << std::setw(12) << summary.p50InUs << std::setw(12) << summary.p99InUs
+         << std::setw(12) << summary.maxInUs << std::defaultfloat << std::endl;
+    }
+  }
+}
+
+void
+dunedaq::sspmodules::DeviceStats::Reset()
+{
+  for (auto cell = fCells.begin(); cell != fCells.end(); ++cell) {
+    cell->calls = 0;
+    cell->totalNs = 0;
+    cell->maxNs = 0;
+    for (auto bucket = cell->buckets.begin(); bucket != cell->buckets.end(); ++bucket) {
+      *bucket = 0;
+    }
+  }
+}
+
+const char*
+dunedaq::sspmodules::DeviceStats::OperationName(Operation_t op)
+{
+  return op < kNOperations ? operationNames[op] : "unknown";
+}
+
+#endif // SSPMODULES_SRC_ANLBOARD_DEVICESTATS_CXX_
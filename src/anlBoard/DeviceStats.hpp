@@ -0,0 +1,115 @@
+/**
+ * @file DeviceStats.hpp
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_DEVICESTATS_HPP_
+#define SSPMODULES_SRC_ANLBOARD_DEVICESTATS_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+namespace dunedaq {
+namespace sspmodules {
+
+//Call counts and latency histograms for the operations of a Device, kept per
+//operation and register address range. Recording is a handful of relaxed
+//atomic adds, so it stays on all the time, and may happen from any thread.
+class DeviceStats{
+
+public:
+
+  enum Operation_t{kRead,kReadMask,kReadForced,kWrite,kWriteMask,kSet,kClear,kArrayRead,kArrayWrite,kWriteList,
+                   kReceive,kReceiveV,kQueueStatus,kWaitForData,kPurgeComm,kPurgeData,kNOperations};
+
+  //Registers are binned by the top nibble of their address (0x4... ARM side,
+  //0x8... DSP side). Data channel operations all fall in range 0.
+  static constexpr unsigned int kNRanges = 16;
+
+  //Bucket i counts calls taking from 2^i up to 2^(i+1) ns; the last is open ended
+  static constexpr unsigned int kNBuckets = 32;
+
+  //Pass as range to Summarize to cover all address ranges
+  static constexpr unsigned int kAllRanges = kNRanges;
+
+  DeviceStats();
+
+  void Record(Operation_t op, unsigned int address, std::chrono::nanoseconds elapsed);
+
+  //Percentiles are the upper edge of the histogram bucket they fall in
+  struct Summary{
+    unsigned long calls;  // NOLINT(runtime/int)
+    double meanInUs;
+    double p50InUs;
+    double p99InUs;
+    double maxInUs;
+  };
+
+  Summary Summarize(Operation_t op, unsigned int range = kAllRanges) const;
+
+  //Combined over several operations, e.g. all kinds of register write
+  Summary Summarize(const std::vector<Operation_t>& ops) const;
+
+  //One line per operation and address range which has been called
+  void Dump(std::ostream& os) const;
+
+  void Reset();
+
+  static const char* OperationName(Operation_t op);
+
+  //Records the time from its construction to its destruction
+  class Timer{
+
+  public:
+
+    Timer(DeviceStats& stats, Operation_t op, unsigned int address = 0)
+      : fStats(stats)
+      , fOp(op)
+      , fAddress(address)
+      , fStart(std::chrono::steady_clock::now())
+    {}
+
+    ~Timer(){
+      fStats.Record(fOp, fAddress, std::chrono::steady_clock::now() - fStart);
+    }
+
+  private:
+
+    DeviceStats& fStats;
+
+    Operation_t fOp;
+
+    unsigned int fAddress;
+
+    std::chrono::steady_clock::time_point fStart;
+  };
+
+private:
+
+  struct Cell{
+    std::atomic<unsigned long> calls;  // NOLINT(runtime/int)
+    std::atomic<unsigned long> totalNs;  // NOLINT(runtime/int)
+    std::atomic<unsigned long> maxNs;  // NOLINT(runtime/int)
+    std::array<std::atomic<unsigned long>, kNBuckets> buckets;  // NOLINT(runtime/int)
+  };
+
+  //Add the cells for op over the given ranges into the totals
+  void Accumulate(Operation_t op, unsigned int firstRange, unsigned int endRange, unsigned long& calls,  // NOLINT(runtime/int)
+                  unsigned long& totalNs, unsigned long& maxNs,  // NOLINT(runtime/int)
+                  std::array<unsigned long, kNBuckets>& buckets) const;  // NOLINT(runtime/int)
+
+  static Summary MakeSummary(unsigned long calls, unsigned long totalNs, unsigned long maxNs,  // NOLINT(runtime/int)
+                             const std::array<unsigned long, kNBuckets>& buckets);  // NOLINT(runtime/int)
+
+  std::array<Cell, kNOperations * kNRanges> fCells;
+};
+
+} // namespace sspmodules
+} // namespace dunedaq
+
+#endif // SSPMODULES_SRC_ANLBOARD_DEVICESTATS_HPP_
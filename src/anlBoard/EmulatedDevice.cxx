@@ -15,6 +15,7 @@
 //#include "dune-artdaq/DAQLogger/DAQLogger.hh"
 #include "RegMap.hpp"
 
+#include <algorithm>
 #include <cstdlib>
 #include <random>
 #include <chrono>
@@ -22,7 +23,25 @@
 #include <memory>
 #include <vector>
 
-dunedaq::sspmodules::EmulatedDevice::EmulatedDevice(unsigned int deviceNumber){
+namespace {
+const unsigned int headerSizeInWords=sizeof(dunedaq::fddetdataformats::ssp::EventHeader)/sizeof(unsigned int);
+}
+
+dunedaq::sspmodules::EmulatedDevice::EmulatedDevice(unsigned int deviceNumber)
+  : fEmulatedReadIndex(0)
+  , fEventRate(10.)
+  , fPayloadWords(100)
+  , fNChannels(12)
+  , fMaxBufferedWords(1<<24)
+  , fGeneratedEvents(0)
+  , fOverflowEvents(0)
+  , fAccessLatencyInUs(0)
+  , fModelPdts(false)
+  , fPdtsLockTimeInUs(0)
+  , fPdtsInReset(false)
+  , fReadTransactions(0)
+  , fWriteTransactions(0)
+{
   fDeviceNumber=deviceNumber;
   isOpen=false;
   fEmulatorThread=0;
@@ -43,91 +62,234 @@ void dunedaq::sspmodules::EmulatedDevice::Close(){
 
 void dunedaq::sspmodules::EmulatedDevice::DevicePurgeComm()
 {
+  DeviceStats::Timer timer(fStats,DeviceStats::kPurgeComm);
 }
 
 void dunedaq::sspmodules::EmulatedDevice::DevicePurgeData()
 {
-  while(fEmulatedBuffer.size()){
-    fEmulatedBuffer.pop();
-  }
+  DeviceStats::Timer timer(fStats,DeviceStats::kPurgeData);
+  std::lock_guard<std::mutex> lock(fBufferMutex);
+  fEmulatedBuffer.clear();
+  fEmulatedReadIndex=0;
 }
 
 void dunedaq::sspmodules::EmulatedDevice::DeviceQueueStatus (unsigned int* numWords)
 {
-  (*numWords)=fEmulatedBuffer.size();
+  DeviceStats::Timer timer(fStats,DeviceStats::kQueueStatus);
+  std::lock_guard<std::mutex> lock(fBufferMutex);
+  (*numWords)=fEmulatedBuffer.size()-fEmulatedReadIndex;
 }
 
 void dunedaq::sspmodules::EmulatedDevice::DeviceReceive(std::vector<unsigned int>& data, unsigned int size){
+  DeviceStats::Timer timer(fStats,DeviceStats::kReceive);
 
   data.clear();
-  unsigned int element;
-  for(unsigned int iElement=0;iElement<size;++iElement){
-    bool gotData=fEmulatedBuffer.try_pop(element,std::chrono::microseconds(1000));
-    if(gotData){
-      data.push_back(element);
-	} else {
-      break;
-    }
+  std::unique_lock<std::mutex> lock(fBufferMutex);
+  fBufferCondition.wait_for(lock,std::chrono::microseconds(1000),[this]{return fEmulatedBuffer.size()>fEmulatedReadIndex;});
+
+  size_t available=fEmulatedBuffer.size()-fEmulatedReadIndex;
+  size_t nWords=std::min(static_cast<size_t>(size),available);
+  data.assign(fEmulatedBuffer.begin()+fEmulatedReadIndex,fEmulatedBuffer.begin()+fEmulatedReadIndex+nWords);
+  fEmulatedReadIndex+=nWords;
+  this->ReclaimBuffer();
+}
+
+unsigned int dunedaq::sspmodules::EmulatedDevice::DeviceReceiveV(const ReceiveSegment* segments, unsigned int nSegments){
+  DeviceStats::Timer timer(fStats,DeviceStats::kReceiveV);
+
+  std::unique_lock<std::mutex> lock(fBufferMutex);
+  fBufferCondition.wait_for(lock,std::chrono::microseconds(1000),[this]{return fEmulatedBuffer.size()>fEmulatedReadIndex;});
+
+  unsigned int received=0;
+  for(unsigned int i=0;i<nSegments&&fEmulatedReadIndex<fEmulatedBuffer.size();++i){
+    size_t nWords=std::min(static_cast<size_t>(segments[i].size),fEmulatedBuffer.size()-fEmulatedReadIndex);
+    std::copy(fEmulatedBuffer.begin()+fEmulatedReadIndex,fEmulatedBuffer.begin()+fEmulatedReadIndex+nWords,segments[i].data);
+    fEmulatedReadIndex+=nWords;
+    received+=nWords;
   }
+  this->ReclaimBuffer();
+  return received;
+}
+
+void dunedaq::sspmodules::EmulatedDevice::ReclaimBuffer(){
+
+  //Reclaim the space which has been read, without moving data on every call
+  if(fEmulatedReadIndex==fEmulatedBuffer.size()){
+    fEmulatedBuffer.clear();
+    fEmulatedReadIndex=0;
+  } else if(fEmulatedReadIndex>fEmulatedBuffer.size()/2){
+    fEmulatedBuffer.erase(fEmulatedBuffer.begin(),fEmulatedBuffer.begin()+fEmulatedReadIndex);
+    fEmulatedReadIndex=0;
+  }
+}
+
+bool dunedaq::sspmodules::EmulatedDevice::DeviceWaitForData(unsigned int timeoutInUs){
+  DeviceStats::Timer timer(fStats,DeviceStats::kWaitForData);
+  std::unique_lock<std::mutex> lock(fBufferMutex);
+  return fBufferCondition.wait_for(lock,std::chrono::microseconds(timeoutInUs),[this]{return fEmulatedBuffer.size()>fEmulatedReadIndex;});
 }
 
 //==============================================================================
 // Command Functions
 //==============================================================================
 
-//Only respond to specific commands needed to simulate normal operations
+//Registers are held in an in-memory file seeded from the RegMap default values.
+//Read and write masks from RegMap are honoured; unnamed addresses behave as plain
+//32-bit read/write registers. Each call counts as one transaction on the link.
+
 void dunedaq::sspmodules::EmulatedDevice::DeviceRead (unsigned int address, unsigned int* value)
 {
-  (void)address;
-  (void)value;
+  DeviceStats::Timer timer(fStats,DeviceStats::kRead,address);
+  this->Transaction(fReadTransactions);
+  std::lock_guard<std::mutex> lock(fRegisterMutex);
+  (*value)=this->ReadRegister(address);
 }
 
 void dunedaq::sspmodules::EmulatedDevice::DeviceReadMask (unsigned int address, unsigned int mask, unsigned int* value)
 {
-  (void)address;
-  (void)mask;
-  (void)value;
+  DeviceStats::Timer timer(fStats,DeviceStats::kReadMask,address);
+  this->Transaction(fReadTransactions);
+  std::lock_guard<std::mutex> lock(fRegisterMutex);
+  (*value)=this->ReadRegister(address)&mask;
 }
 
 void dunedaq::sspmodules::EmulatedDevice::DeviceWrite (unsigned int address, unsigned int value)
 {
-  dunedaq::sspmodules::RegMap& duneReg=dunedaq::sspmodules::RegMap::Get();
-  if(address==duneReg.master_logic_control&&value==0x00000001){
-    this->Start();
-  } else if (address==duneReg.event_data_control&&value==0x00020001){
-    this->Stop();
-  }
+  DeviceStats::Timer timer(fStats,DeviceStats::kWrite,address);
+  this->Transaction(fWriteTransactions);
+  this->WriteRegister(address,0xFFFFFFFF,value);
 }
 
 void dunedaq::sspmodules::EmulatedDevice::DeviceWriteMask (unsigned int address, unsigned int mask, unsigned int value)
 {
-  (void)address;
-  (void)mask;
-  (void)value;
+  DeviceStats::Timer timer(fStats,DeviceStats::kWriteMask,address);
+  this->Transaction(fWriteTransactions);
+  this->WriteRegister(address,mask,value);
 }
 
 void dunedaq::sspmodules::EmulatedDevice::DeviceSet (unsigned int address, unsigned int mask)
 {
-  DeviceWriteMask(address, mask, 0xFFFFFFFF);
+  DeviceStats::Timer timer(fStats,DeviceStats::kSet,address);
+  this->Transaction(fWriteTransactions);
+  this->WriteRegister(address,mask,0xFFFFFFFF);
 }
 
 void dunedaq::sspmodules::EmulatedDevice::DeviceClear (unsigned int address, unsigned int mask)
 {
-  DeviceWriteMask(address, mask, 0x00000000);
+  DeviceStats::Timer timer(fStats,DeviceStats::kClear,address);
+  this->Transaction(fWriteTransactions);
+  this->WriteRegister(address,mask,0x00000000);
 }
 
 void dunedaq::sspmodules::EmulatedDevice::DeviceArrayRead (unsigned int address, unsigned int size, unsigned int* data)
 {
-  (void)address;
-  (void)size;
-  (void)data;
+  DeviceStats::Timer timer(fStats,DeviceStats::kArrayRead,address);
+  this->Transaction(fReadTransactions);
+  std::lock_guard<std::mutex> lock(fRegisterMutex);
+  for(unsigned int i=0;i<size;++i){
+    data[i]=this->ReadRegister(address+0x4*i);
+  }
 }
 
 void dunedaq::sspmodules::EmulatedDevice::DeviceArrayWrite (unsigned int address, unsigned int size, unsigned int* data)
 {
-  (void)address;
-  (void)size;
-  (void)data;
+  DeviceStats::Timer timer(fStats,DeviceStats::kArrayWrite,address);
+  this->Transaction(fWriteTransactions);
+  for(unsigned int i=0;i<size;++i){
+    this->WriteRegister(address+0x4*i,0xFFFFFFFF,data[i]);
+  }
+}
+
+void dunedaq::sspmodules::EmulatedDevice::ResetTransactionCounts(){
+  fReadTransactions=0;
+  fWriteTransactions=0;
+}
+
+void dunedaq::sspmodules::EmulatedDevice::Transaction(std::atomic<unsigned long>& counter){  // NOLINT(runtime/int)
+  ++counter;
+  if(fAccessLatencyInUs){
+    std::this_thread::sleep_for(std::chrono::microseconds(fAccessLatencyInUs));
+  }
+}
+
+unsigned int dunedaq::sspmodules::EmulatedDevice::StoredValue(unsigned int address) const{
+  auto reg=fRegisters.find(address);
+  if(reg!=fRegisters.end()){
+    return reg->second;
+  }
+  const dunedaq::sspmodules::RegMap::Register* named=dunedaq::sspmodules::RegMap::Get().Find(address);
+  return named?named->Default():0x00000000;
+}
+
+unsigned int dunedaq::sspmodules::EmulatedDevice::ReadRegister(unsigned int address){
+  dunedaq::sspmodules::RegMap& duneReg=dunedaq::sspmodules::RegMap::Get();
+  unsigned int value=this->StoredValue(address);
+
+  //Endpoint state lives in the low nibble of pdts_status
+  if(address==duneReg.pdts_status){
+    value=(value&~0xFu)|this->PdtsState();
+  }
+
+  const dunedaq::sspmodules::RegMap::Register* named=duneReg.Find(address);
+  return named?(value&named->ReadMask()):value;
+}
+
+void dunedaq::sspmodules::EmulatedDevice::WriteRegister(unsigned int address, unsigned int mask, unsigned int value){
+  dunedaq::sspmodules::RegMap& duneReg=dunedaq::sspmodules::RegMap::Get();
+
+  unsigned int oldValue;
+  unsigned int newValue;
+  {
+    std::lock_guard<std::mutex> lock(fRegisterMutex);
+    const dunedaq::sspmodules::RegMap::Register* named=duneReg.Find(address);
+    if(named){
+      mask&=named->WriteMask();
+    }
+    oldValue=this->StoredValue(address);
+    newValue=(oldValue&~mask)|(value&mask);
+    fRegisters[address]=newValue;
+
+    //Putting the endpoint into reset (bit 31 of pdts_control) drops it out of
+    //sync; it starts locking again once released.
+    if(address==duneReg.pdts_control){
+      if(newValue&0x80000000){
+        fPdtsInReset=true;
+      } else if(fPdtsInReset||oldValue!=newValue){
+        fPdtsInReset=false;
+        fPdtsReleaseTime=std::chrono::steady_clock::now();
+      }
+    }
+  }
+
+  //Bit 0 of master_logic_control releases the master logic reset, resetting
+  //the links and flags in event_data_control ends the run, and PurgeDDR drops
+  //any data still buffered
+  if(address==duneReg.master_logic_control){
+    if((newValue&0x1)&&!(oldValue&0x1)){
+      this->Start();
+    } else if(!(newValue&0x1)&&(oldValue&0x1)){
+      this->Stop();
+    }
+  } else if(address==duneReg.event_data_control&&(value&mask)==0x00020001){
+    this->Stop();
+  } else if(address==duneReg.PurgeDDR&&(value&mask&0x1)){
+    this->DevicePurgeData();
+  }
+}
+
+unsigned int dunedaq::sspmodules::EmulatedDevice::PdtsState() const{
+  if(!fModelPdts){
+    return 0x8;
+  }
+  if(fPdtsInReset){
+    return 0x0;
+  }
+  //Endpoint only locks once the DSP is running from the external clock
+  dunedaq::sspmodules::RegMap& duneReg=dunedaq::sspmodules::RegMap::Get();
+  if(!(this->StoredValue(duneReg.dsp_clock_control)&0x1)){
+    return 0x3;
+  }
+  return (std::chrono::steady_clock::now()-fPdtsReleaseTime>=std::chrono::microseconds(fPdtsLockTimeInUs))?0x8:0x6;
 }
 
 //==============================================================
@@ -135,8 +297,13 @@ void dunedaq::sspmodules::EmulatedDevice::DeviceArrayWrite (unsigned int address
 //==============================================================
 
 void dunedaq::sspmodules::EmulatedDevice::Start(){
+  if(fEmulatorThread){
+    return;
+  }
   //dune::DAQLogger::LogDebug("SSP_EmulatedDevice")<<"Creating emulator thread..."<<std::endl;
   fEmulatorShouldStop=false;
+  fGeneratedEvents=0;
+  fOverflowEvents=0;
   fEmulatorThread=std::unique_ptr<std::thread>(new std::thread(&dunedaq::sspmodules::EmulatedDevice::EmulatorLoop,this));
 }
 
@@ -151,68 +318,107 @@ void dunedaq::sspmodules::EmulatedDevice::Stop(){
 void dunedaq::sspmodules::EmulatedDevice::EmulatorLoop(){
 
   //dune::DAQLogger::LogDebug("SSP_EmulatedDevice")<<"Starting emulator loop..."<<std::endl;
-  static unsigned int headerSizeInWords=sizeof(dunedaq::fddetdataformats::ssp::EventHeader)/sizeof(unsigned int);
 
   //We want to generate events on random channels at random times
   std::default_random_engine generator;
-  std::exponential_distribution<double> timeDistribution(1./100000.);//10Hz
-  std::uniform_int_distribution<int> channelDistribution(0,11);//12 channels
+  std::exponential_distribution<double> timeDistribution(fEventRate>0?fEventRate:1.);
+  std::uniform_int_distribution<unsigned int> channelDistribution(0,fNChannels?fNChannels-1:0);
+
+  const unsigned int eventSizeInWords=headerSizeInWords+fPayloadWords;
+  //Don't let one block hold the buffer lock for too long at high rates
+  const size_t maxBlockEvents=std::max(1u,(1u<<16)/eventSizeInWords);
 
-  std::chrono::steady_clock::time_point runStartTime = std::chrono::steady_clock::now();
+  std::vector<unsigned int> block;
+  block.reserve(maxBlockEvents*eventSizeInWords);
+
+  std::chrono::steady_clock::time_point nextEventTime = std::chrono::steady_clock::now();
+  if(fEventRate>0){
+    nextEventTime+=std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeDistribution(generator)));
+  }
 
   //Thread should terminate once "hardware" stop request has been issued
   while(!fEmulatorShouldStop){
 
-    //Wait for random period, then generate event with system timestamp and random channel
-    double waitTime = timeDistribution(generator);
-    usleep(static_cast<int>(waitTime));
-    std::chrono::steady_clock::time_point eventTime = std::chrono::steady_clock::now();
-    unsigned long eventTimestamp = (std::chrono::duration_cast<std::chrono::duration<unsigned long,std::ratio<1, 150000000>>>(eventTime - runStartTime)).count(); //150MHz clock // NOLINT(runtime/int)
-    int channel = channelDistribution(generator);
-
-    //Build an event header. 
-    dunedaq::fddetdataformats::ssp::EventHeader header;
-
-    //Standard header word
-    header.header=0xAAAAAAAA;
-    //Assign a junk payload of 100 words
-    header.length=headerSizeInWords+100;
-    //Assign randomly generated channel
-    header.group2=channel;
-    
-    //Set timestamps correctly? Need to figure out better how these are defined
-    for(int iWord=1;iWord<=3;++iWord){
-      header.timestamp[iWord]=(eventTimestamp>>(iWord)*16)%65536;
-    }
-    for(int iWord=0;iWord<=2;++iWord){
-      header.intTimestamp[iWord+1]=(eventTimestamp>>(iWord)*16)%65536;//First word of intTimestamp is reserved
-    }
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
 
-    //Don't bother with any other fields for now
-    header.group1=0x01;
-    header.triggerID=0x0;
-    header.peakSumLow=0x0;
-    header.group3=0x0;
-    header.preriseLow=0x0;
-    header.group4=0x0;
-    header.intSumHigh=0x0;
-    header.baseline=0x0;
-
-    for(int iWord=0;iWord<=3;++iWord){
-      header.cfdPoint[iWord]=0;
+    //Sleep until the next event is due, waking at least every 10ms to check for stop
+    if(fEventRate<=0||nextEventTime>now){
+      std::chrono::steady_clock::time_point wakeTime = now+std::chrono::milliseconds(10);
+      std::this_thread::sleep_until(fEventRate>0?std::min(nextEventTime,wakeTime):wakeTime);
+      continue;
     }
 
-    
-    //Push header onto emulated buffer
-    unsigned int* headerPtr=(unsigned int*)(&header);
-    for(unsigned int element=0;element<headerSizeInWords;++element){
-      fEmulatedBuffer.push(headerPtr[element]);
+    //Build every event which has fallen due, stamped with the time it was due
+    block.clear();
+    size_t nEvents=0;
+    while(nextEventTime<=now&&nEvents<maxBlockEvents){
+      this->AppendEvent(block,nextEventTime,channelDistribution(generator));
+      ++nEvents;
+      nextEventTime+=std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeDistribution(generator)));
     }
-
-    //Payload contains 100 words; each word is just iWord+channel number
-    for(unsigned int iWord=0;iWord<100;++iWord){
-      fEmulatedBuffer.push(iWord+channel);
+    fGeneratedEvents+=nEvents;
+
+    {
+      std::lock_guard<std::mutex> lock(fBufferMutex);
+      size_t buffered=fEmulatedBuffer.size()-fEmulatedReadIndex;
+      if(buffered+block.size()>fMaxBufferedWords){
+        //FIFO full: keep as many whole events as fit
+        size_t nFit=buffered<fMaxBufferedWords?(fMaxBufferedWords-buffered)/eventSizeInWords:0;
+        fOverflowEvents+=nEvents-nFit;
+        block.resize(nFit*eventSizeInWords);
+      }
+      fEmulatedBuffer.insert(fEmulatedBuffer.end(),block.begin(),block.end());
     }
+    fBufferCondition.notify_all();
+  }
+}
+
+void dunedaq::sspmodules::EmulatedDevice::AppendEvent(std::vector<unsigned int>& block,
+                                                      std::chrono::steady_clock::time_point eventTime,
+                                                      unsigned int channel){
+
+  //Timestamps count 150MHz ticks of the steady clock, so that whoever reads the
+  //events out can tell how long ago they were generated
+  unsigned long eventTimestamp = (std::chrono::duration_cast<std::chrono::duration<unsigned long,std::ratio<1, 150000000>>>(eventTime.time_since_epoch())).count(); //150MHz clock // NOLINT(runtime/int)
+
+  //Build an event header.
+  dunedaq::fddetdataformats::ssp::EventHeader header;
+
+  //Standard header word
+  header.header=0xAAAAAAAA;
+  //Assign a junk payload
+  header.length=headerSizeInWords+fPayloadWords;
+  //Assign randomly generated channel
+  header.group2=channel;
+
+  //Set timestamps correctly? Need to figure out better how these are defined
+  for(int iWord=0;iWord<=3;++iWord){
+    header.timestamp[iWord]=(eventTimestamp>>(iWord)*16)%65536;
+  }
+  for(int iWord=0;iWord<=2;++iWord){
+    header.intTimestamp[iWord+1]=(eventTimestamp>>(iWord)*16)%65536;//First word of intTimestamp is reserved
+  }
+
+  //Don't bother with any other fields for now
+  header.group1=0x01;
+  header.triggerID=0x0;
+  header.peakSumLow=0x0;
+  header.group3=0x0;
+  header.preriseLow=0x0;
+  header.group4=0x0;
+  header.intSumHigh=0x0;
+  header.baseline=0x0;
+
+  for(int iWord=0;iWord<=3;++iWord){
+    header.cfdPoint[iWord]=0;
+  }
+
+  const unsigned int* headerPtr=reinterpret_cast<const unsigned int*>(&header);
+  block.insert(block.end(),headerPtr,headerPtr+headerSizeInWords);
+
+  //Payload words are just iWord+channel number
+  for(unsigned int iWord=0;iWord<fPayloadWords;++iWord){
+    block.push_back(iWord+channel);
   }
 }
 
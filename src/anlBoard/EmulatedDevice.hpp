@@ -11,7 +11,6 @@
 #include "fddetdataformats/SSPTypes.hpp"
 
 #include "Device.hpp"
-#include "SafeQueue.hpp"
 
 #include <iostream>
 #include <iomanip>
@@ -21,7 +20,13 @@
 #include <cstring>
 #include <unistd.h>
 #include <memory>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 namespace dunedaq {
@@ -53,6 +58,10 @@ public:
 
   virtual void DeviceReceive(std::vector<unsigned int>& data, unsigned int size);
 
+  virtual unsigned int DeviceReceiveV(const ReceiveSegment* segments, unsigned int nSegments);
+
+  virtual bool DeviceWaitForData(unsigned int timeoutInUs);
+
   virtual void DeviceRead(unsigned int address, unsigned int* value);
 
   virtual void DeviceReadMask(unsigned int address, unsigned int mask, unsigned int* value);
@@ -69,6 +78,48 @@ public:
 
   virtual void DeviceArrayWrite(unsigned int address, unsigned int size, unsigned int* data);
 
+  //Emulator settings. These take effect at the next run start.
+
+  //Mean aggregate event rate over all channels, in Hz. Events arrive at
+  //random (exponentially distributed) intervals.
+  void SetEventRate(double eventsPerSecond){fEventRate=eventsPerSecond;}
+
+  //Number of payload words after each event header. The event length field
+  //is 16 bits, so this is limited to 65535 words less the header.
+  void SetPayloadWords(unsigned int nWords){
+    fPayloadWords=std::min(nWords,0xFFFFu-static_cast<unsigned int>(sizeof(dunedaq::fddetdataformats::ssp::EventHeader)/sizeof(unsigned int)));
+  }
+
+  //Events are spread at random over channels 0 to nChannels-1
+  void SetNChannels(unsigned int nChannels){fNChannels=nChannels;}
+
+  //Size of the emulated data FIFO. Events generated while it is full are
+  //dropped, as they would be on the board.
+  void SetBufferWords(unsigned int nWords){fMaxBufferedWords=nWords;}
+
+  //Counters for the current/last run
+  inline unsigned long GeneratedEvents() const{return fGeneratedEvents;}  // NOLINT(runtime/int)
+
+  inline unsigned long OverflowEvents() const{return fOverflowEvents;}  // NOLINT(runtime/int)
+
+  //Register access settings
+
+  //Time each register transaction takes, to stand in for the round trip to a board
+  void SetAccessLatency(unsigned int latencyInUs){fAccessLatencyInUs=latencyInUs;}
+
+  //Model the timing endpoint: held in reset (state 0x0) while bit 31 of
+  //pdts_control is set, and reaching the running state (0x8) lockTimeInUs after
+  //release, provided the DSP clock is external. Otherwise it always reads 0x8.
+  void SetPdtsModel(bool enable, unsigned int lockTimeInUs=0){fModelPdts=enable;fPdtsLockTimeInUs=lockTimeInUs;}
+
+  //Register transactions since the device was created or the counts were reset.
+  //Array reads/writes count once.
+  inline unsigned long ReadTransactions() const{return fReadTransactions;}  // NOLINT(runtime/int)
+
+  inline unsigned long WriteTransactions() const{return fWriteTransactions;}  // NOLINT(runtime/int)
+
+  void ResetTransactionCounts();
+
 private:
 
   virtual void Open(bool slowControlOnly=false);
@@ -81,9 +132,31 @@ private:
   //Called when appropriate register is set via DeviceWrite
   void Stop();
 
-  //Add fake events to fEmulatedBuffer periodically
+  //Add fake events to fEmulatedBuffer periodically.
+  //All events which have fallen due since the last pass are built into a
+  //block and appended with a single lock, so rates up to MHz are possible.
   void EmulatorLoop();
 
+  //Count a register transaction and wait for the access latency
+  void Transaction(std::atomic<unsigned long>& counter);  // NOLINT(runtime/int)
+
+  //Register file helpers. Must hold fRegisterMutex except for WriteRegister,
+  //which takes it itself so that run start/stop happen outside it.
+  unsigned int StoredValue(unsigned int address) const;
+
+  unsigned int ReadRegister(unsigned int address);
+
+  void WriteRegister(unsigned int address, unsigned int mask, unsigned int value);
+
+  unsigned int PdtsState() const;
+
+  //Drop words already read from the front of fEmulatedBuffer. Call with fBufferMutex held.
+  void ReclaimBuffer();
+
+  //Append one event with the given generation time to block
+  void AppendEvent(std::vector<unsigned int>& block, std::chrono::steady_clock::time_point eventTime,
+                   unsigned int channel);
+
   //Device number to put into event headers
   unsigned int fDeviceNumber;
 
@@ -92,8 +165,47 @@ private:
   //Separate thread to generate fake data asynchronously
   std::unique_ptr<std::thread> fEmulatorThread;
 
-  //Buffer for fake data, popped from by DeviceReceive
-  SafeQueue<unsigned int> fEmulatedBuffer;
+  //Buffer for fake data, read from by DeviceReceive starting at fEmulatedReadIndex.
+  //Guarded by fBufferMutex.
+  std::vector<unsigned int> fEmulatedBuffer;
+
+  size_t fEmulatedReadIndex;
+
+  std::mutex fBufferMutex;
+
+  //Notified when a block is added to fEmulatedBuffer
+  std::condition_variable fBufferCondition;
+
+  double fEventRate;
+
+  unsigned int fPayloadWords;
+
+  unsigned int fNChannels;
+
+  unsigned int fMaxBufferedWords;
+
+  std::atomic<unsigned long> fGeneratedEvents;  // NOLINT(runtime/int)
+
+  std::atomic<unsigned long> fOverflowEvents;  // NOLINT(runtime/int)
+
+  //Register values written so far; anything else reads as its RegMap default
+  std::map<unsigned int, unsigned int> fRegisters;
+
+  std::mutex fRegisterMutex;
+
+  unsigned int fAccessLatencyInUs;
+
+  bool fModelPdts;
+
+  unsigned int fPdtsLockTimeInUs;
+
+  bool fPdtsInReset;
+
+  std::chrono::steady_clock::time_point fPdtsReleaseTime;
+
+  std::atomic<unsigned long> fReadTransactions;  // NOLINT(runtime/int)
+
+  std::atomic<unsigned long> fWriteTransactions;  // NOLINT(runtime/int)
 
   //Set by Stop method; tells emulator thread to stop generating data
   std::atomic<bool> fEmulatorShouldStop;
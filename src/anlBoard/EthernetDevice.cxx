@@ -13,74 +13,240 @@
 //#include "dune-artdaq/DAQLogger/DAQLogger.hh"
 #include "anlExceptions.hpp"
 
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
 #include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
 #include <cstdlib>
+#include <string>
+#include <thread>
 #include <vector>
 
 boost::asio::io_service dunedaq::sspmodules::EthernetDevice::fIo_service;
+std::mutex dunedaq::sspmodules::EthernetDevice::fIoThreadMutex;
+unsigned int dunedaq::sspmodules::EthernetDevice::fIoThreadUsers = 0;
+std::unique_ptr<boost::asio::io_service::work> dunedaq::sspmodules::EthernetDevice::fIoWork;
+std::thread dunedaq::sspmodules::EthernetDevice::fIoThread;
 
 dunedaq::sspmodules::EthernetDevice::EthernetDevice(unsigned long ipAddress)  // NOLINT
   :
   isOpen(false)
-  , fCommSocket(fIo_service)
+  , fCommTimer(fCommIo_service)
+  , fCommSocket(fCommIo_service)
   , fDataSocket(fIo_service)
   , fIP(boost::asio::ip::address_v4(ipAddress))
-{}
+  , fSocketOptions{ 0, 0, true, 0, false }
+  , fEffectiveSocketOptions{ 0, 0, false, 0, false }
+  , fMaxInFlight(1)
+  , fTransactionTimeout(1000)
+  , fConnectTimeout(5000)
+  , fInitialBackoff(1)
+  , fMaxBackoff(100)
+  , fPurgeQuiescence(10)
+  , fLastPurge{ 0, 0 }
+  , fAsyncReceive(false)
+  , fRxRingSize(16)
+  , fRxSlotSize(65536)
+  , fRxReadSlot(0)
+  , fRxReadOffset(0)
+  , fRxFullSlots(0)
+  , fRxBufferedBytes(0)
+  , fRxReadPending(false)
+{
+  ResetCounters();
+}
 
 void
 dunedaq::sspmodules::EthernetDevice::Open(bool slowControlOnly)
 {
 
+  isOpen = false;
   fSlowControlOnly = slowControlOnly;
 
+  // Nothing we remember about the board's registers survives a reconnect
+  fShadow.Clear();
+
   // dune::DAQLogger::LogInfo("SSP_EthernetDevice")<<"Looking for SSP Ethernet device at "<<fIP.to_string()<<std::endl;
-  boost::asio::ip::tcp::resolver resolver(fIo_service);
-  boost::asio::ip::tcp::resolver::query commQuery(fIP.to_string(), slowControlOnly ? "55002" : "55001");
-  boost::asio::ip::tcp::resolver::iterator commEndpointIterator = resolver.resolve(commQuery);
-  boost::asio::connect(fCommSocket, commEndpointIterator);
-
-  if (slowControlOnly) {
-    // dune::DAQLogger::LogInfo("SSP_EthernetDevice")<<"Connected to SSP Ethernet device at
-    // "<<fIP.to_string()<<std::endl;
-    return;
+  Connect(fCommSocket, slowControlOnly ? 55002 : 55001, false);
+
+  if (!slowControlOnly) {
+    // Buffer sizes come from fSocketOptions, which are unset (kernel default)
+    // unless configured. JTH found a 16k receive buffer caused event read errors.
+    try {
+      Connect(fDataSocket, 55010, true);
+    } catch (...) {
+      // Don't leave the board half open
+      boost::system::error_code ignored;
+      fCommSocket.close(ignored);
+      throw;
+    }
   }
 
-  boost::asio::ip::tcp::resolver::query dataQuery(fIP.to_string(), "55010");
-  boost::asio::ip::tcp::resolver::iterator dataEndpointIterator = resolver.resolve(dataQuery);
+  ReadSocketOptions();
+  isOpen = true;
+  // dune::DAQLogger::LogInfo("SSP_EthernetDevice")<<"Connected to SSP Ethernet device at "<<fIP.to_string()<<std::endl;
+}
 
-  boost::asio::connect(fDataSocket, dataEndpointIterator);
+void
+dunedaq::sspmodules::EthernetDevice::Connect(boost::asio::ip::tcp::socket& socket,
+                                             unsigned short port,  // NOLINT(runtime/int)
+                                             bool isData)
+{
+  boost::system::error_code ignored;
+  socket.close(ignored);
 
-  // Set limited receive buffer size to avoid taxing switch
-  // JTH: Remove this since it was causing event read errors. Could try again
-  // with a different value if there are more issues which point to switch problems.
-  //  boost::asio::socket_base::receive_buffer_size option(16384);
-  //  fDataSocket.set_option(option);
+  // Options go on before connecting, since the receive window scale is fixed
+  // during the handshake
+  boost::asio::ip::tcp::endpoint endpoint(fIP, port);
+  socket.open(endpoint.protocol());
+  if (fSocketOptions.receiveBufferSize) {
+    socket.set_option(boost::asio::socket_base::receive_buffer_size(fSocketOptions.receiveBufferSize));
+  }
+  if (fSocketOptions.sendBufferSize) {
+    socket.set_option(boost::asio::socket_base::send_buffer_size(fSocketOptions.sendBufferSize));
+  }
+  if (!isData) {
+    socket.set_option(boost::asio::ip::tcp::no_delay(fSocketOptions.controlNoDelay));
+  }
+#ifdef SO_BUSY_POLL
+  if (isData && fSocketOptions.busyPollInUs) {
+    // Needs CAP_NET_ADMIN to go above net.core.busy_read; failure shows up in the readback
+    int busyPoll = fSocketOptions.busyPollInUs;
+    setsockopt(socket.native_handle(), SOL_SOCKET, SO_BUSY_POLL, &busyPoll, sizeof(busyPoll));
+  }
+#endif
 
-  // dune::DAQLogger::LogInfo("SSP_EthernetDevice")<<"Connected to SSP Ethernet device at "<<fIP.to_string()<<std::endl;
+  // Connect without blocking, so an unreachable board is given up on after
+  // fConnectTimeout rather than the kernel's SYN retry limit
+  socket.non_blocking(true);
+  boost::system::error_code ec;
+  if (::connect(socket.native_handle(), endpoint.data(), endpoint.size()) != 0) {
+    ec = boost::system::error_code(errno, boost::system::system_category());
+  }
+  if (ec == boost::asio::error::in_progress || ec == boost::asio::error::would_block) {
+    pollfd connectPoll;
+    connectPoll.fd = socket.native_handle();
+    connectPoll.events = POLLOUT;
+    // A signal interrupts the wait without ending it; carry on until the deadline
+    auto deadline = std::chrono::steady_clock::now() + fConnectTimeout;
+    int ready = -1;
+    int connectError = EINTR;
+    while (ready < 0 && connectError == EINTR) {
+      auto remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+      if (remaining.count() <= 0) {
+        ready = 0;
+        break;
+      }
+      ready = ::poll(&connectPoll, 1, remaining.count());
+      connectError = errno;
+    }
+    if (ready == 0) {
+      socket.close(ignored);
+      throw(ETCPTimeout("Timed out connecting to SSP at " + fIP.to_string() + ":" + std::to_string(port)));
+    }
+    if (ready > 0) {
+      socklen_t length = sizeof(connectError);
+      getsockopt(socket.native_handle(), SOL_SOCKET, SO_ERROR, &connectError, &length);
+    }
+    ec = boost::system::error_code(connectError, boost::system::system_category());
+  }
+  if (ec) {
+    socket.close(ignored);
+    throw(ETCPError("Could not connect to SSP at " + fIP.to_string() + ":" + std::to_string(port) + ": " +
+                    ec.message()));
+  }
+  socket.non_blocking(false);
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::ReadSocketOptions()
+{
+  boost::asio::ip::tcp::socket& bufferSocket = fDataSocket.is_open() ? fDataSocket : fCommSocket;
+
+  boost::asio::socket_base::receive_buffer_size receiveBufferSize;
+  bufferSocket.get_option(receiveBufferSize);
+  fEffectiveSocketOptions.receiveBufferSize = receiveBufferSize.value();
+
+  boost::asio::socket_base::send_buffer_size sendBufferSize;
+  bufferSocket.get_option(sendBufferSize);
+  fEffectiveSocketOptions.sendBufferSize = sendBufferSize.value();
+
+  boost::asio::ip::tcp::no_delay noDelay;
+  fCommSocket.get_option(noDelay);
+  fEffectiveSocketOptions.controlNoDelay = noDelay.value();
+
+  fEffectiveSocketOptions.busyPollInUs = 0;
+#ifdef SO_BUSY_POLL
+  if (fDataSocket.is_open()) {
+    int busyPoll = 0;
+    socklen_t length = sizeof(busyPoll);
+    if (getsockopt(fDataSocket.native_handle(), SOL_SOCKET, SO_BUSY_POLL, &busyPoll, &length) == 0) {
+      fEffectiveSocketOptions.busyPollInUs = busyPoll;
+    }
+  }
+#endif
+
+  fEffectiveSocketOptions.busyPollRead = fSocketOptions.busyPollRead;
 }
 
 void
 dunedaq::sspmodules::EthernetDevice::Close()
 {
   isOpen = false;
+  // Stop any read pending on the data socket before closing it, so that its
+  // handler has run and the io thread is released
+  this->DeviceAsyncReceive(false);
+  // Let the board take another connection on these ports
+  boost::system::error_code ignored;
+  fCommSocket.close(ignored);
+  fDataSocket.close(ignored);
   // dune::DAQLogger::LogInfo("SSP_EthernetDevice")<<"Device closed"<<std::endl;
 }
 
 void
 dunedaq::sspmodules::EthernetDevice::DevicePurgeComm(void)
 {
+  DeviceStats::Timer timer(fStats, DeviceStats::kPurgeComm);
   DevicePurge(fCommSocket);
 }
 
 void
 dunedaq::sspmodules::EthernetDevice::DevicePurgeData(void)
 {
+  DeviceStats::Timer timer(fStats, DeviceStats::kPurgeData);
+  if (fAsyncReceive) {
+    // The socket belongs to the io_service thread, so just empty the ring.
+    // A pending read keeps its slot, which becomes the next one to drain.
+    std::lock_guard<std::mutex> lock(fRxMutex);
+    fLastPurge.bytes = fRxBufferedBytes;
+    fLastPurge.timeInUs = 0;
+    fRxReadSlot = (fRxReadSlot + fRxFullSlots) % fRxRing.size();
+    fRxReadOffset = 0;
+    fRxFullSlots = 0;
+    fRxBufferedBytes = 0;
+    PostAsyncRead();
+    return;
+  }
   DevicePurge(fDataSocket);
 }
 
 void
 dunedaq::sspmodules::EthernetDevice::DeviceQueueStatus(unsigned int* numWords)
 {
+  DeviceStats::Timer timer(fStats, DeviceStats::kQueueStatus);
+  if (fAsyncReceive) {
+    std::lock_guard<std::mutex> lock(fRxMutex);
+    if (fRxError) {
+      throw boost::system::system_error(fRxError);
+    }
+    (*numWords) = fRxBufferedBytes / sizeof(unsigned int);
+    return;
+  }
   unsigned int numBytes = fDataSocket.available();
   (*numWords) = numBytes / sizeof(unsigned int);
 }
@@ -88,19 +254,278 @@ dunedaq::sspmodules::EthernetDevice::DeviceQueueStatus(unsigned int* numWords)
 void
 dunedaq::sspmodules::EthernetDevice::DeviceReceive(std::vector<unsigned int>& data, unsigned int size)
 {
+  DeviceStats::Timer timer(fStats, DeviceStats::kReceive);
   data.resize(size);
+  if (fAsyncReceive) {
+    // Only hand out whole words; any trailing bytes stay in the ring
+    unsigned int dataReturned =
+      TakeAsyncData(reinterpret_cast<unsigned char*>(data.data()), size * sizeof(unsigned int)); // NOLINT
+    data.resize(dataReturned / sizeof(unsigned int));
+    return;
+  }
   unsigned int dataReturned = fDataSocket.read_some(boost::asio::buffer(data));
   if (dataReturned < size * sizeof(unsigned int)) {
     data.resize(dataReturned / sizeof(unsigned int));
   }
 }
 
+unsigned int
+dunedaq::sspmodules::EthernetDevice::DeviceReceiveV(const ReceiveSegment* segments, unsigned int nSegments)
+{
+  DeviceStats::Timer timer(fStats, DeviceStats::kReceiveV);
+  if (fAsyncReceive) {
+    unsigned int received = 0;
+    for (unsigned int i = 0; i < nSegments; ++i) {
+      unsigned int bytes = TakeAsyncData(reinterpret_cast<unsigned char*>(segments[i].data), // NOLINT
+                                         segments[i].size * sizeof(unsigned int));
+      received += bytes / sizeof(unsigned int);
+      if (bytes < segments[i].size * sizeof(unsigned int)) {
+        break;
+      }
+    }
+    return received;
+  }
+
+  std::vector<iovec>& iov = fReceiveIov;
+  iov.resize(std::min(nSegments, static_cast<unsigned int>(IOV_MAX)));
+  for (unsigned int i = 0; i < iov.size(); ++i) {
+    iov[i].iov_base = segments[i].data;
+    iov[i].iov_len = segments[i].size * sizeof(unsigned int);
+  }
+
+  ssize_t bytesRead = ::readv(fDataSocket.native_handle(), iov.data(), iov.size());
+  if (bytesRead < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return 0;
+    }
+    throw boost::system::system_error(boost::system::error_code(errno, boost::system::system_category()));
+  }
+  if (bytesRead == 0) {
+    throw boost::system::system_error(boost::asio::error::eof);
+  }
+
+  // Segments hold whole words, so a word cut short by the read lies within one
+  // segment. Wait for the rest of it rather than drop it.
+  std::size_t partialBytes = bytesRead % sizeof(unsigned int);
+  if (partialBytes) {
+    std::size_t offset = bytesRead;
+    unsigned int i = 0;
+    while (offset >= iov[i].iov_len) {
+      offset -= iov[i].iov_len;
+      ++i;
+    }
+    boost::asio::read(
+      fDataSocket,
+      boost::asio::buffer(static_cast<unsigned char*>(iov[i].iov_base) + offset, sizeof(unsigned int) - partialBytes));
+    bytesRead += sizeof(unsigned int) - partialBytes;
+  }
+  return bytesRead / sizeof(unsigned int);
+}
+
+bool
+dunedaq::sspmodules::EthernetDevice::DeviceWaitForData(unsigned int timeoutInUs)
+{
+  DeviceStats::Timer timer(fStats, DeviceStats::kWaitForData);
+  if (!fAsyncReceive && fSocketOptions.busyPollRead) {
+    // Spin on non-blocking peeks, which also drive SO_BUSY_POLL if it is set,
+    // rather than sleeping 100us between polls
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeoutInUs);
+    unsigned int word;
+    do {
+      ssize_t peeked = ::recv(fDataSocket.native_handle(), &word, sizeof(word), MSG_PEEK | MSG_DONTWAIT);
+      if (peeked == sizeof(word)) {
+        return true;
+      }
+      if (peeked == 0 || (peeked < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        // Closed or failed; leave it to DeviceReceive to report
+        return false;
+      }
+    } while (std::chrono::steady_clock::now() < deadline);
+    return false;
+  }
+
+  if (!fAsyncReceive) {
+    return Device::DeviceWaitForData(timeoutInUs);
+  }
+
+  std::unique_lock<std::mutex> lock(fRxMutex);
+  fRxCondition.wait_for(lock, std::chrono::microseconds(timeoutInUs), [this] {
+    return fRxBufferedBytes >= sizeof(unsigned int) || fRxError;
+  });
+  if (fRxError) {
+    throw boost::system::system_error(fRxError);
+  }
+  return fRxBufferedBytes >= sizeof(unsigned int);
+}
+
+//==============================================================================
+// Asynchronous data channel
+//==============================================================================
+
+void
+dunedaq::sspmodules::EthernetDevice::SetAsyncRing(unsigned int nBuffers, unsigned int bufferSizeInBytes)
+{
+  fRxRingSize = std::max(nBuffers, 2u);
+  fRxSlotSize = std::max(bufferSizeInBytes, (unsigned int)sizeof(unsigned int));
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::DeviceAsyncReceive(bool enable)
+{
+  if (enable == fAsyncReceive) {
+    return;
+  }
+
+  if (enable) {
+    // Buffers are allocated once here and reused until async mode is switched off
+    fRxRing.resize(fRxRingSize);
+    for (auto slot = fRxRing.begin(); slot != fRxRing.end(); ++slot) {
+      slot->data.resize(fRxSlotSize);
+      slot->filled = 0;
+    }
+    fRxReadSlot = 0;
+    fRxReadOffset = 0;
+    fRxFullSlots = 0;
+    fRxBufferedBytes = 0;
+    fRxError = boost::system::error_code();
+
+    AcquireIoThread();
+    std::lock_guard<std::mutex> lock(fRxMutex);
+    fAsyncReceive = true;
+    PostAsyncRead();
+    return;
+  }
+
+  // Cancel the outstanding read and wait for its handler to run
+  {
+    std::unique_lock<std::mutex> lock(fRxMutex);
+    fAsyncReceive = false;
+    if (fRxReadPending) {
+      boost::system::error_code ec;
+      fDataSocket.cancel(ec);
+    }
+    fRxCondition.wait(lock, [this] { return !fRxReadPending; });
+    fRxBufferedBytes = 0;
+    fRxFullSlots = 0;
+  }
+  ReleaseIoThread();
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::PostAsyncRead()
+{
+  if (!fAsyncReceive || fRxReadPending || fRxError || fRxFullSlots == fRxRing.size()) {
+    return;
+  }
+
+  RxSlot& slot = fRxRing[(fRxReadSlot + fRxFullSlots) % fRxRing.size()];
+  fRxReadPending = true;
+  fDataSocket.async_read_some(
+    boost::asio::buffer(slot.data),
+    [this](const boost::system::error_code& ec, std::size_t bytesRead) { HandleAsyncRead(ec, bytesRead); });
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::HandleAsyncRead(const boost::system::error_code& ec, std::size_t bytesRead)
+{
+  std::lock_guard<std::mutex> lock(fRxMutex);
+  fRxReadPending = false;
+
+  if (ec) {
+    if (ec != boost::asio::error::operation_aborted) {
+      fRxError = ec;
+    }
+    fRxCondition.notify_all();
+    return;
+  }
+
+  fRxRing[(fRxReadSlot + fRxFullSlots) % fRxRing.size()].filled = bytesRead;
+  ++fRxFullSlots;
+  fRxBufferedBytes += bytesRead;
+
+  // If the ring is now full, the next read is posted when the consumer frees a slot
+  PostAsyncRead();
+  fRxCondition.notify_all();
+}
+
+unsigned int
+dunedaq::sspmodules::EthernetDevice::TakeAsyncData(unsigned char* dest, unsigned int nBytes)
+{
+  std::lock_guard<std::mutex> lock(fRxMutex);
+  if (fRxError) {
+    throw boost::system::system_error(fRxError);
+  }
+
+  unsigned int toCopy = std::min(nBytes, (unsigned int)(fRxBufferedBytes / sizeof(unsigned int) * sizeof(unsigned int)));
+  unsigned int copied = 0;
+
+  while (copied < toCopy) {
+    RxSlot& slot = fRxRing[fRxReadSlot];
+    std::size_t chunk = std::min(slot.filled - fRxReadOffset, (std::size_t)(toCopy - copied));
+    std::memcpy(dest + copied, slot.data.data() + fRxReadOffset, chunk);
+    copied += chunk;
+    fRxReadOffset += chunk;
+
+    // Hand used-up slots back to the io_service thread
+    if (fRxReadOffset == slot.filled) {
+      fRxReadOffset = 0;
+      fRxReadSlot = (fRxReadSlot + 1) % fRxRing.size();
+      --fRxFullSlots;
+    }
+  }
+  fRxBufferedBytes -= copied;
+
+  // Restart reading if the ring had filled up
+  PostAsyncRead();
+  return copied;
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::AcquireIoThread()
+{
+  std::lock_guard<std::mutex> lock(fIoThreadMutex);
+  if (fIoThreadUsers++) {
+    return;
+  }
+  fIo_service.restart();
+  fIoWork.reset(new boost::asio::io_service::work(fIo_service));
+  fIoThread = std::thread([] { fIo_service.run(); });
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::ReleaseIoThread()
+{
+  std::lock_guard<std::mutex> lock(fIoThreadMutex);
+  if (--fIoThreadUsers) {
+    return;
+  }
+  fIoWork.reset();
+  fIoThread.join();
+}
+
 //==============================================================================
 // Command Functions
 //==============================================================================
 
 void
 dunedaq::sspmodules::EthernetDevice::DeviceRead(unsigned int address, unsigned int* value)
+{
+  DeviceStats::Timer timer(fStats, DeviceStats::kRead, address);
+  if (fShadow.Lookup(address, *value)) {
+    return;
+  }
+  this->ReadForced(address, value);
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::DeviceReadForced(unsigned int address, unsigned int* value)
+{
+  DeviceStats::Timer timer(fStats, DeviceStats::kReadForced, address);
+  this->ReadForced(address, value);
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::ReadForced(unsigned int address, unsigned int* value)
 {
   dunedaq::fddetdataformats::ssp::CtrlPacket tx;
   dunedaq::fddetdataformats::ssp::CtrlPacket rx;
@@ -117,11 +542,24 @@ dunedaq::sspmodules::EthernetDevice::DeviceRead(unsigned int address, unsigned i
 
   SendReceive(tx, rx, txSize, rxSizeExpected, 3);
   *value = rx.data[0];
+  fShadow.Store(address, *value);
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::DeviceInvalidateCache()
+{
+  fShadow.Clear();
 }
 
 void
 dunedaq::sspmodules::EthernetDevice::DeviceReadMask(unsigned int address, unsigned int mask, unsigned int* value)
 {
+  DeviceStats::Timer timer(fStats, DeviceStats::kReadMask, address);
+  if (fShadow.Lookup(address, *value)) {
+    *value &= mask;
+    return;
+  }
+
   dunedaq::fddetdataformats::ssp::CtrlPacket tx;
   dunedaq::fddetdataformats::ssp::CtrlPacket rx;
   unsigned int txSize;
@@ -143,6 +581,12 @@ dunedaq::sspmodules::EthernetDevice::DeviceReadMask(unsigned int address, unsign
 void
 dunedaq::sspmodules::EthernetDevice::DeviceWrite(unsigned int address, unsigned int value)
 {
+  DeviceStats::Timer timer(fStats, DeviceStats::kWrite, address);
+  if (fShadow.Unchanged(address, value)) {
+    fShadow.CountSkippedWrites();
+    return;
+  }
+
   dunedaq::fddetdataformats::ssp::CtrlPacket tx;
   dunedaq::fddetdataformats::ssp::CtrlPacket rx;
   unsigned int txSize;
@@ -157,12 +601,30 @@ dunedaq::sspmodules::EthernetDevice::DeviceWrite(unsigned int address, unsigned
   txSize = sizeof(dunedaq::fddetdataformats::ssp::CtrlHeader) + sizeof(unsigned int);
   rxSizeExpected = sizeof(dunedaq::fddetdataformats::ssp::CtrlHeader);
 
-  SendReceive(tx, rx, txSize, rxSizeExpected, 3);
+  try {
+    SendReceive(tx, rx, txSize, rxSizeExpected, 3);
+  } catch (...) {
+    fShadow.Invalidate(address);
+    throw;
+  }
+  fShadow.Store(address, value);
 }
 
 void
 dunedaq::sspmodules::EthernetDevice::DeviceWriteMask(unsigned int address, unsigned int mask, unsigned int value)
 {
+  DeviceStats::Timer timer(fStats, DeviceStats::kWriteMask, address);
+  this->WriteMask(address, mask, value);
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::WriteMask(unsigned int address, unsigned int mask, unsigned int value)
+{
+  if (fShadow.Unchanged(address, value, mask)) {
+    fShadow.CountSkippedWrites();
+    return;
+  }
+
   dunedaq::fddetdataformats::ssp::CtrlPacket tx;
   dunedaq::fddetdataformats::ssp::CtrlPacket rx;
   unsigned int txSize;
@@ -178,25 +640,44 @@ dunedaq::sspmodules::EthernetDevice::DeviceWriteMask(unsigned int address, unsig
   txSize = sizeof(dunedaq::fddetdataformats::ssp::CtrlHeader) + (sizeof(unsigned int) * 2);
   rxSizeExpected = sizeof(dunedaq::fddetdataformats::ssp::CtrlHeader) + sizeof(unsigned int);
 
-  SendReceive(tx, rx, txSize, rxSizeExpected, 3);
+  try {
+    SendReceive(tx, rx, txSize, rxSizeExpected, 3);
+  } catch (...) {
+    fShadow.Invalidate(address);
+    throw;
+  }
+  fShadow.StoreMasked(address, mask, value);
 }
 
 void
 dunedaq::sspmodules::EthernetDevice::DeviceSet(unsigned int address, unsigned int mask)
 {
-  DeviceWriteMask(address, mask, 0xFFFFFFFF);
+  DeviceStats::Timer timer(fStats, DeviceStats::kSet, address);
+  this->WriteMask(address, mask, 0xFFFFFFFF);
 }
 
 void
 dunedaq::sspmodules::EthernetDevice::DeviceClear(unsigned int address, unsigned int mask)
 {
-  DeviceWriteMask(address, mask, 0x00000000);
+  DeviceStats::Timer timer(fStats, DeviceStats::kClear, address);
+  this->WriteMask(address, mask, 0x00000000);
 }
 
 void
 dunedaq::sspmodules::EthernetDevice::DeviceArrayRead(unsigned int address, unsigned int size, unsigned int* data)
 {
+  DeviceStats::Timer timer(fStats, DeviceStats::kArrayRead, address);
   unsigned int i = 0;
+
+  for (i = 0; i < size && fShadow.Known(address + 0x4 * i); i++) {
+  }
+  if (i == size) {
+    for (i = 0; i < size; i++) {
+      fShadow.Lookup(address + 0x4 * i, data[i]);
+    }
+    return;
+  }
+
   dunedaq::fddetdataformats::ssp::CtrlPacket tx;
   dunedaq::fddetdataformats::ssp::CtrlPacket rx;
   unsigned int txSize;
@@ -213,18 +694,38 @@ dunedaq::sspmodules::EthernetDevice::DeviceArrayRead(unsigned int address, unsig
   SendReceive(tx, rx, txSize, rxSizeExpected, 3);
   for (i = 0; i < rx.header.size; i++) {
     data[i] = rx.data[i];
+    fShadow.Store(address + 0x4 * i, data[i]);
   }
 }
 
 void
 dunedaq::sspmodules::EthernetDevice::DeviceArrayWrite(unsigned int address, unsigned int size, unsigned int* data)
 {
+  DeviceStats::Timer timer(fStats, DeviceStats::kArrayWrite, address);
   unsigned int i = 0;
   dunedaq::fddetdataformats::ssp::CtrlPacket tx;
   dunedaq::fddetdataformats::ssp::CtrlPacket rx;
   unsigned int txSize;
   unsigned int rxSizeExpected;
 
+  // Only send the span between the first and last registers that would change
+  unsigned int first = 0;
+  while (first < size && fShadow.Unchanged(address + 0x4 * first, data[first])) {
+    first++;
+  }
+  if (first == size) {
+    fShadow.CountSkippedWrites(size);
+    return;
+  }
+  unsigned int last = size;
+  while (fShadow.Unchanged(address + 0x4 * (last - 1), data[last - 1])) {
+    last--;
+  }
+  fShadow.CountSkippedWrites(size - (last - first));
+  address += 0x4 * first;
+  data += first;
+  size = last - first;
+
   tx.header.length = sizeof(dunedaq::fddetdataformats::ssp::CtrlHeader) + (sizeof(uint) * size);
   tx.header.address = address;
   tx.header.command = dunedaq::fddetdataformats::ssp::cmdArrayWrite;
@@ -237,13 +738,139 @@ dunedaq::sspmodules::EthernetDevice::DeviceArrayWrite(unsigned int address, unsi
     tx.data[i] = data[i];
   }
 
-  SendReceive(tx, rx, txSize, rxSizeExpected, 3);
+  try {
+    SendReceive(tx, rx, txSize, rxSizeExpected, 3);
+  } catch (...) {
+    for (i = 0; i < size; i++) {
+      fShadow.Invalidate(address + 0x4 * i);
+    }
+    throw;
+  }
+  for (i = 0; i < size; i++) {
+    fShadow.Store(address + 0x4 * i, data[i]);
+  }
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::DeviceWriteList(const std::vector<std::pair<unsigned int, unsigned int>>& writes)
+{
+  DeviceStats::Timer timer(fStats, DeviceStats::kWriteList, writes.empty() ? 0 : writes.front().first);
+  fTransactions.clear();
+
+  for (auto write = writes.begin(); write != writes.end(); ++write) {
+    if (fShadow.Unchanged(write->first, write->second)) {
+      fShadow.CountSkippedWrites();
+      continue;
+    }
+    fTransactions.emplace_back();
+    CtrlTransaction& trans = fTransactions.back();
+    trans.tx.header.length = sizeof(dunedaq::fddetdataformats::ssp::CtrlHeader) + sizeof(uint);
+    trans.tx.header.address = write->first;
+    trans.tx.header.command = dunedaq::fddetdataformats::ssp::cmdWrite;
+    trans.tx.header.size = 1;
+    trans.tx.header.status = dunedaq::fddetdataformats::ssp::statusNoError;
+    trans.tx.data[0] = write->second;
+    trans.txSize = sizeof(dunedaq::fddetdataformats::ssp::CtrlHeader) + sizeof(unsigned int);
+    trans.rxSizeExpected = sizeof(dunedaq::fddetdataformats::ssp::CtrlHeader);
+  }
+
+  try {
+    SendReceivePipelined(fTransactions, 3);
+  } catch (...) {
+    for (auto trans = fTransactions.begin(); trans != fTransactions.end(); ++trans) {
+      fShadow.Invalidate(trans->tx.header.address);
+    }
+    throw;
+  }
+  for (auto trans = fTransactions.begin(); trans != fTransactions.end(); ++trans) {
+    fShadow.Store(trans->tx.header.address, trans->tx.data[0]);
+  }
 }
 
 //==============================================================================
 // Support Functions
 //==============================================================================
 
+void
+dunedaq::sspmodules::EthernetDevice::SetControlOptions(const ControlOptions& options)
+{
+  this->SetMaxInFlight(options.maxInFlight);
+  this->SetTransactionTimeout(options.transactionTimeoutInMs);
+  this->SetRetryBackoff(options.initialBackoffInMs, options.maxBackoffInMs);
+  this->SetPurgeQuiescence(options.purgeQuiescenceInMs);
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::SetRetryBackoff(unsigned int initialBackoffInMs, unsigned int maxBackoffInMs)
+{
+  fInitialBackoff = std::chrono::milliseconds(initialBackoffInMs);
+  fMaxBackoff = std::chrono::milliseconds(std::max(initialBackoffInMs, maxBackoffInMs));
+}
+
+const dunedaq::sspmodules::EthernetDevice::CommandCounters&
+dunedaq::sspmodules::EthernetDevice::Counters(unsigned int command) const
+{
+  return fCounters[command < fCounters.size() ? command : static_cast<unsigned int>(dunedaq::fddetdataformats::ssp::cmdNone)];
+}
+
+dunedaq::sspmodules::EthernetDevice::CommandCounters&
+dunedaq::sspmodules::EthernetDevice::CountersFor(unsigned int command)
+{
+  return fCounters[command < fCounters.size() ? command : static_cast<unsigned int>(dunedaq::fddetdataformats::ssp::cmdNone)];
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::ResetCounters()
+{
+  for (auto counters = fCounters.begin(); counters != fCounters.end(); ++counters) {
+    counters->transactions = 0;
+    counters->retries = 0;
+    counters->timeouts = 0;
+  }
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::Backoff(unsigned int timesTried)
+{
+  std::chrono::milliseconds delay = fInitialBackoff;
+  for (unsigned int i = 1; i < timesTried && delay < fMaxBackoff; ++i) {
+    delay *= 2;
+  }
+  std::this_thread::sleep_for(std::min(delay, fMaxBackoff));
+}
+
+template<typename Operation>
+void
+dunedaq::sspmodules::EthernetDevice::RunCommOperation(Operation operation, std::chrono::steady_clock::time_point deadline)
+{
+  boost::system::error_code result;
+  bool timedOut = false;
+
+  fCommIo_service.restart();
+  fCommTimer.expires_at(deadline);
+  fCommTimer.async_wait([this, &timedOut](const boost::system::error_code& ec) {
+    if (!ec) {
+      timedOut = true;
+      boost::system::error_code ignored;
+      fCommSocket.cancel(ignored);
+    }
+  });
+  operation([this, &result](const boost::system::error_code& ec, std::size_t) {
+    result = ec;
+    fCommTimer.cancel();
+  });
+
+  // Returns once both the operation and the timer handlers have run
+  fCommIo_service.run();
+
+  if (timedOut && result == boost::asio::error::operation_aborted) {
+    throw(ETCPTimeout("Timed out waiting for SSP at " + fIP.to_string()));
+  }
+  if (result) {
+    throw(ETCPError(result.message()));
+  }
+}
+
 void
 dunedaq::sspmodules::EthernetDevice::SendReceive(dunedaq::fddetdataformats::ssp::CtrlPacket& tx,
                                                  dunedaq::fddetdataformats::ssp::CtrlPacket& rx,
@@ -253,19 +880,28 @@ dunedaq::sspmodules::EthernetDevice::SendReceive(dunedaq::fddetdataformats::ssp:
 {
   unsigned int timesTried = 0;
   bool success = false;
+  CommandCounters& counters = CountersFor(tx.header.command);
+  ++counters.transactions;
 
+  // No fixed delays needed here: ReceiveEthernet waits until the whole
+  // reply packet has arrived, however it is split up on the wire, or
+  // until the deadline for the exchange passes.
   while (!success) {
     try {
-      SendEthernet(tx, txSize);
-      // Insert small delay between send and receive on Linux
-      usleep(100);
-      ReceiveEthernet(rx, rxSizeExpected);
-      usleep(2000);
+      auto deadline = std::chrono::steady_clock::now() + fTransactionTimeout;
+      SendEthernet(tx, txSize, deadline);
+      ReceiveEthernet(rx, rxSizeExpected, deadline);
       success = true;
-    } catch (ETCPError&) {
+    } catch (ETCPError& e) {
+      if (dynamic_cast<ETCPTimeout*>(&e)) {
+        ++counters.timeouts;
+      }
       if (timesTried < retryCount) {
-        DevicePurgeComm();
         ++timesTried;
+        ++counters.retries;
+        // Give a late reply the chance to arrive so the purge catches it
+        Backoff(timesTried);
+        DevicePurgeComm();
         // dune::DAQLogger::LogWarning("SSP_EthernetDevice")<<"Send/receive failed "<<timesTried<<" times on Ethernet
         // link, retrying..."<<std::endl;
       } else {
@@ -278,19 +914,113 @@ dunedaq::sspmodules::EthernetDevice::SendReceive(dunedaq::fddetdataformats::ssp:
 }
 
 void
-dunedaq::sspmodules::EthernetDevice::SendEthernet(dunedaq::fddetdataformats::ssp::CtrlPacket& tx, unsigned int txSize)
+dunedaq::sspmodules::EthernetDevice::SendReceivePipelined(std::vector<CtrlTransaction>& transactions,
+                                                          unsigned int retryCount)
 {
-  unsigned int txSizeWritten = fCommSocket.write_some(boost::asio::buffer(static_cast<void*>(&tx), txSize));
-  if (txSizeWritten != txSize) {
-    throw(ETCPError(""));
+  unsigned int timesTried = 0;
+  unsigned int nDone = 0;
+
+  for (auto trans = transactions.begin(); trans != transactions.end(); ++trans) {
+    ++CountersFor(trans->tx.header.command).transactions;
+  }
+
+  while (nDone < transactions.size()) {
+    // After a failure, everything from the first unanswered request is resent
+    unsigned int nSent = nDone;
+    try {
+      std::vector<boost::asio::const_buffer> txBuffers;
+      txBuffers.reserve(fMaxInFlight);
+
+      while (nDone < transactions.size()) {
+        // Top up the window of outstanding requests with a single gathered write
+        txBuffers.clear();
+        while (nSent < transactions.size() && nSent - nDone < fMaxInFlight) {
+          txBuffers.push_back(boost::asio::buffer(static_cast<void*>(&transactions[nSent].tx), transactions[nSent].txSize));
+          ++nSent;
+        }
+        if (!txBuffers.empty()) {
+          RunCommOperation(
+            [this, &txBuffers](auto handler) { boost::asio::async_write(fCommSocket, txBuffers, handler); },
+            std::chrono::steady_clock::now() + fTransactionTimeout);
+        }
+
+        // Replies come back in request order, so the next one answers the
+        // oldest request outstanding. Check it does, to catch a stream which
+        // has fallen out of step.
+        CtrlTransaction& trans = transactions[nDone];
+        ReceiveEthernet(trans.rx, trans.rxSizeExpected, std::chrono::steady_clock::now() + fTransactionTimeout);
+        if (trans.rx.header.address != trans.tx.header.address || trans.rx.header.command != trans.tx.header.command) {
+          throw(ETCPError("Reply does not match oldest outstanding request"));
+        }
+        ++nDone;
+      }
+    } catch (ETCPError& e) {
+      CommandCounters& counters = CountersFor(transactions[nDone].tx.header.command);
+      if (dynamic_cast<ETCPTimeout*>(&e)) {
+        ++counters.timeouts;
+      }
+      if (timesTried < retryCount) {
+        ++timesTried;
+        ++counters.retries;
+        Backoff(timesTried);
+        DevicePurgeComm();
+      } else {
+        throw;
+      }
+    }
   }
 }
 
+void
+dunedaq::sspmodules::EthernetDevice::SendEthernet(dunedaq::fddetdataformats::ssp::CtrlPacket& tx, unsigned int txSize)
+{
+  SendEthernet(tx, txSize, std::chrono::steady_clock::now() + fTransactionTimeout);
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::SendEthernet(dunedaq::fddetdataformats::ssp::CtrlPacket& tx,
+                                                  unsigned int txSize,
+                                                  std::chrono::steady_clock::time_point deadline)
+{
+  RunCommOperation(
+    [this, &tx, txSize](auto handler) {
+      boost::asio::async_write(fCommSocket, boost::asio::buffer(static_cast<void*>(&tx), txSize), handler);
+    },
+    deadline);
+}
+
 void
 dunedaq::sspmodules::EthernetDevice::ReceiveEthernet(dunedaq::fddetdataformats::ssp::CtrlPacket& rx, unsigned int rxSizeExpected)
 {
-  unsigned int rxSizeReturned = fCommSocket.read_some(boost::asio::buffer(static_cast<void*>(&rx), rxSizeExpected));
-  if (rxSizeReturned != rxSizeExpected) {
+  ReceiveEthernet(rx, rxSizeExpected, std::chrono::steady_clock::now() + fTransactionTimeout);
+}
+
+void
+dunedaq::sspmodules::EthernetDevice::ReceiveEthernet(dunedaq::fddetdataformats::ssp::CtrlPacket& rx,
+                                                     unsigned int rxSizeExpected,
+                                                     std::chrono::steady_clock::time_point deadline)
+{
+  static const unsigned int headerSize = sizeof(dunedaq::fddetdataformats::ssp::CtrlHeader);
+
+  // Read the header first, then however much payload it says follows, so that
+  // a short (error) reply is consumed whole and the stream stays in step.
+  RunCommOperation(
+    [this, &rx](auto handler) {
+      boost::asio::async_read(fCommSocket, boost::asio::buffer(static_cast<void*>(&rx), headerSize), handler);
+    },
+    deadline);
+  if (rx.header.length < headerSize || rx.header.length > sizeof(dunedaq::fddetdataformats::ssp::CtrlPacket)) {
+    throw(ETCPError("Bad length in reply header"));
+  }
+  if (rx.header.length > headerSize) {
+    RunCommOperation(
+      [this, &rx](auto handler) {
+        boost::asio::async_read(
+          fCommSocket, boost::asio::buffer(static_cast<void*>(&rx.data[0]), rx.header.length - headerSize), handler);
+      },
+      deadline);
+  }
+  if (rx.header.length != rxSizeExpected) {
     throw(ETCPError(""));
   }
 }
@@ -298,29 +1028,36 @@ dunedaq::sspmodules::EthernetDevice::ReceiveEthernet(dunedaq::fddetdataformats::
 void
 dunedaq::sspmodules::EthernetDevice::DevicePurge(boost::asio::ip::tcp::socket& socket)
 {
-  bool done = false;
-  unsigned int bytesQueued = 0;
-  unsigned int sleepTime = 0;
-
-  // Keep getting data from channel until queue is empty
-  do {
-    bytesQueued = socket.available();
-
-    // Read data from device, up to 256 bytes
-    if (bytesQueued != 0) {
-      sleepTime = 0;
-      unsigned int bytesToGet = std::min((unsigned int)256, bytesQueued);
-      std::vector<char> junkBuf(bytesToGet);
-      socket.read_some(boost::asio::buffer(junkBuf, bytesToGet));
-    } else {      // If queue is empty, wait a bit and check that it hasn't filled up again, then return
-      usleep(1000); // 1ms
-      sleepTime += 1000;
-      bytesQueued = socket.available();
-      if (bytesQueued == 0 && sleepTime > 1000000) {
-        done = 1;
-      }
+  static const std::size_t purgeBufferSize = 1 << 20;
+
+  auto start = std::chrono::steady_clock::now();
+  unsigned long bytesDiscarded = 0; // NOLINT(runtime/int)
+
+  if (fPurgeBuffer.empty()) {
+    fPurgeBuffer.resize(purgeBufferSize);
+  }
+
+  pollfd socketPoll;
+  socketPoll.fd = socket.native_handle();
+  socketPoll.events = POLLIN;
+
+  // Drain whatever is queued in large reads, then wait for more to arrive.
+  // Finished once the socket has been quiet for the whole window, or has closed.
+  while (true) {
+    if (socket.available()) {
+      bytesDiscarded += socket.read_some(boost::asio::buffer(fPurgeBuffer));
+      continue;
+    }
+    socketPoll.revents = 0;
+    if (::poll(&socketPoll, 1, fPurgeQuiescence.count()) <= 0 || !(socketPoll.revents & POLLIN) ||
+        !socket.available()) {
+      break;
     }
-  } while (!done);
+  }
+
+  fLastPurge.bytes = bytesDiscarded;
+  fLastPurge.timeInUs =
+    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
 }
 
 #endif // SSPMODULES_SRC_ANLBOARD_ETHERNETDEVICE_CXX_
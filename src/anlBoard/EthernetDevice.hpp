@@ -11,15 +11,25 @@
 #include "fddetdataformats/SSPTypes.hpp"
 
 #include "Device.hpp"
+#include "RegisterCache.hpp"
 #include "boost/asio.hpp"
 
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <utility>
 #include <vector>
 
 namespace dunedaq {
@@ -44,10 +54,31 @@ public:
 
   virtual void DevicePurgeData();
 
+  virtual PurgeReport LastPurge() const{return fLastPurge;}
+
+  //A purge reads until nothing more has arrived for this long
+  void SetPurgeQuiescence(unsigned int quietTimeInMs){fPurgeQuiescence = std::chrono::milliseconds(quietTimeInMs);}
+
   virtual void DeviceQueueStatus(unsigned int* numWords);
 
   virtual void DeviceReceive(std::vector<unsigned int>& data, unsigned int size);
 
+  //A single readv on the data socket in polled mode
+  virtual unsigned int DeviceReceiveV(const ReceiveSegment* segments, unsigned int nSegments);
+
+  virtual bool DeviceWaitForData(unsigned int timeoutInUs);
+
+  //In asynchronous mode an async_read_some is kept posted on the data socket,
+  //run by a thread shared between all Ethernet devices, and data lands in a
+  //ring of preallocated buffers. DeviceQueueStatus and DeviceReceive then
+  //work from the ring, and DeviceWaitForData sleeps until data arrives.
+  //Data still in the ring when asynchronous mode is switched off is dropped.
+  virtual void DeviceAsyncReceive(bool enable);
+
+  //Size of the asynchronous receive ring. Takes effect next time asynchronous
+  //mode is switched on.
+  void SetAsyncRing(unsigned int nBuffers, unsigned int bufferSizeInBytes);
+
   virtual void DeviceRead(unsigned int address, unsigned int* value);
 
   virtual void DeviceReadMask(unsigned int address, unsigned int mask, unsigned int* value);
@@ -64,14 +95,104 @@ public:
 
   virtual void DeviceArrayWrite(unsigned int address, unsigned int size, unsigned int* data);
 
+  //Pipelined: keeps up to fMaxInFlight writes outstanding on the comm socket
+  virtual void DeviceWriteList(const std::vector<std::pair<unsigned int, unsigned int>>& writes);
+
+  virtual void DeviceReadForced(unsigned int address, unsigned int* value);
+
+  virtual void DeviceInvalidateCache();
+
+  //Shadow copy of configuration-only registers. Writes which would not change
+  //them are skipped, and reads of them are answered without going to the board.
+  inline const RegisterCache& Shadow() const{
+    return fShadow;
+  }
+
+  //Socket tuning, applied when the device is opened. Zero sizes leave the
+  //kernel defaults in place.
+  struct SocketOptions{
+    unsigned int receiveBufferSize;  //SO_RCVBUF in bytes, on both sockets
+    unsigned int sendBufferSize;     //SO_SNDBUF in bytes, on both sockets
+    bool controlNoDelay;             //TCP_NODELAY on the comm socket
+    unsigned int busyPollInUs;       //SO_BUSY_POLL on the data socket
+    bool busyPollRead;               //DeviceWaitForData spins instead of sleeping between polls
+  };
+
+  //Takes effect next time the device is opened
+  void SetSocketOptions(const SocketOptions& options){fSocketOptions = options;}
+
+  //Settings as read back from the sockets after the last Open, so buffer
+  //sizes are as the kernel clamped (and, on Linux, doubled) them
+  inline const SocketOptions& EffectiveSocketOptions() const{return fEffectiveSocketOptions;}
+
+  //Maximum number of requests sent ahead of their replies by SendReceivePipelined.
+  //Only raise it above 1 for firmware known to take pipelined requests; see fMaxInFlight.
+  void SetMaxInFlight(unsigned int maxInFlight){fMaxInFlight = maxInFlight ? maxInFlight : 1;}
+
+  //Control channel settings, as handed over by DeviceManager when the device is opened
+  struct ControlOptions{
+    unsigned int maxInFlight;             //see SetMaxInFlight
+    unsigned int transactionTimeoutInMs;  //see SetTransactionTimeout
+    unsigned int initialBackoffInMs;      //see SetRetryBackoff
+    unsigned int maxBackoffInMs;
+    unsigned int purgeQuiescenceInMs;     //see SetPurgeQuiescence
+  };
+
+  //Takes effect immediately
+  void SetControlOptions(const ControlOptions& options);
+
+  //Deadline for one request/reply exchange on the comm socket. If the board
+  //has not answered in full by then, the exchange fails with ETCPTimeout.
+  void SetTransactionTimeout(unsigned int timeoutInMs){fTransactionTimeout = std::chrono::milliseconds(timeoutInMs);}
+
+  //Time allowed for each socket to connect when the device is opened
+  void SetConnectTimeout(unsigned int timeoutInMs){fConnectTimeout = std::chrono::milliseconds(timeoutInMs);}
+
+  //Wait before the first retry of a failed exchange, doubling for each
+  //further retry up to maxBackoffInMs
+  void SetRetryBackoff(unsigned int initialBackoffInMs, unsigned int maxBackoffInMs);
+
+  //Comm socket statistics for one command type
+  struct CommandCounters{
+    std::atomic<unsigned long> transactions;  // NOLINT(runtime/int)
+    std::atomic<unsigned long> retries;  // NOLINT(runtime/int)
+    std::atomic<unsigned long> timeouts;  // NOLINT(runtime/int)
+  };
+
+  //Counters for a command type (cmdRead, cmdWrite, ...)
+  const CommandCounters& Counters(unsigned int command) const;
+
+  void ResetCounters();
+
+  //One request/reply exchange on the comm socket
+  struct CtrlTransaction{
+    dunedaq::fddetdataformats::ssp::CtrlPacket tx;
+    dunedaq::fddetdataformats::ssp::CtrlPacket rx;
+    unsigned int txSize;
+    unsigned int rxSizeExpected;
+  };
+
   //Internal functions - make public so debugging code can access them
 
   void SendReceive(dunedaq::fddetdataformats::ssp::CtrlPacket& tx, dunedaq::fddetdataformats::ssp::CtrlPacket& rx, unsigned int txSize, unsigned int rxSizeExpected, unsigned int retryCount=0);
 
+  //Send all transactions, keeping up to fMaxInFlight requests outstanding.
+  //Replies are taken strictly in order: each one must answer the oldest
+  //request still outstanding.
+  void SendReceivePipelined(std::vector<CtrlTransaction>& transactions, unsigned int retryCount=0);
+
+  //Both give up with ETCPTimeout at the deadline, which SendReceive sets from
+  //the transaction timeout. With no deadline given they allow one timeout from now.
   void SendEthernet(dunedaq::fddetdataformats::ssp::CtrlPacket& tx, unsigned int txSize);
 
+  void SendEthernet(dunedaq::fddetdataformats::ssp::CtrlPacket& tx, unsigned int txSize, std::chrono::steady_clock::time_point deadline);
+
   void ReceiveEthernet(dunedaq::fddetdataformats::ssp::CtrlPacket& rx, unsigned int rxSizeExpected);
 
+  void ReceiveEthernet(dunedaq::fddetdataformats::ssp::CtrlPacket& rx, unsigned int rxSizeExpected, std::chrono::steady_clock::time_point deadline);
+
+  //Discard everything queued on the socket, returning once it has been quiet
+  //for the purge quiescence window
   void DevicePurge(boost::asio::ip::tcp::socket& socket);
 
 private:
@@ -82,11 +203,129 @@ private:
 
   static boost::asio::io_service fIo_service;
 
+  //The comm socket has an io_service of its own, run only by the calling
+  //thread for the length of one operation, so that it can be bounded by
+  //fCommTimer whether or not the shared io_service thread is running.
+  boost::asio::io_service fCommIo_service;
+
+  boost::asio::steady_timer fCommTimer;
+
   boost::asio::ip::tcp::socket fCommSocket;
   boost::asio::ip::tcp::socket fDataSocket;
 
   boost::asio::ip::address fIP;
 
+  SocketOptions fSocketOptions;
+
+  //Reused by DeviceReceiveV
+  std::vector<iovec> fReceiveIov;
+
+  SocketOptions fEffectiveSocketOptions;
+
+  //Open the socket, apply fSocketOptions to it, then connect to the given board
+  //port. Throws ETCPTimeout if the board does not answer within fConnectTimeout.
+  void Connect(boost::asio::ip::tcp::socket& socket, unsigned short port, bool isData);  // NOLINT(runtime/int)
+
+  //Read back what was applied into fEffectiveSocketOptions
+  void ReadSocketOptions();
+
+  //The work of DeviceReadForced and DeviceWriteMask, without timing it, so that
+  //DeviceRead, DeviceSet and DeviceClear are each counted once under their own operation
+  void ReadForced(unsigned int address, unsigned int* value);
+
+  void WriteMask(unsigned int address, unsigned int mask, unsigned int value);
+
+  //Nothing yet shows that the SSP firmware accepts a second request on the
+  //control port (55001) before it has answered the first, so this defaults
+  //to 1 and DeviceWriteList sends one request at a time. Raise it only after
+  //checking on hardware that replies still come back whole and in order.
+  unsigned int fMaxInFlight;
+
+  std::chrono::milliseconds fTransactionTimeout;
+
+  std::chrono::milliseconds fConnectTimeout;
+
+  std::chrono::milliseconds fInitialBackoff;
+
+  std::chrono::milliseconds fMaxBackoff;
+
+  std::array<CommandCounters, dunedaq::fddetdataformats::ssp::cmdNumCommands> fCounters;
+
+  std::chrono::milliseconds fPurgeQuiescence;
+
+  //Allocated on first use and kept for later purges
+  std::vector<char> fPurgeBuffer;
+
+  PurgeReport fLastPurge;
+
+  //Counters to update for a command; unknown commands are lumped in with cmdNone
+  CommandCounters& CountersFor(unsigned int command);
+
+  //Sleep before retry number timesTried (counting from 1)
+  void Backoff(unsigned int timesTried);
+
+  //Run the operation just started on fCommSocket until it completes or the
+  //deadline passes. On a timeout the operation is cancelled and ETCPTimeout thrown.
+  template<typename Operation>
+  void RunCommOperation(Operation operation, std::chrono::steady_clock::time_point deadline);
+
+  //Reused by DeviceWriteList to avoid allocating transactions on each call
+  std::vector<CtrlTransaction> fTransactions;
+
+  RegisterCache fShadow;
+
+  //One buffer of the asynchronous receive ring
+  struct RxSlot{
+    std::vector<unsigned char> data;
+    std::size_t filled;
+  };
+
+  //Post a read into the next free slot. Call with fRxMutex held.
+  void PostAsyncRead();
+
+  void HandleAsyncRead(const boost::system::error_code& ec, std::size_t bytesRead);
+
+  //Copy up to nBytes out of the ring. Returns number of bytes copied.
+  unsigned int TakeAsyncData(unsigned char* dest, unsigned int nBytes);
+
+  //Start the shared io_service thread for the first user, stop it after the last
+  static void AcquireIoThread();
+  static void ReleaseIoThread();
+
+  bool fAsyncReceive;
+
+  unsigned int fRxRingSize;
+
+  unsigned int fRxSlotSize;
+
+  std::vector<RxSlot> fRxRing;
+
+  //Slot being drained by the consumer, read offset in it, and number of
+  //slots holding data. The slot being filled follows the last full one.
+  unsigned int fRxReadSlot;
+
+  std::size_t fRxReadOffset;
+
+  unsigned int fRxFullSlots;
+
+  std::size_t fRxBufferedBytes;
+
+  bool fRxReadPending;
+
+  boost::system::error_code fRxError;
+
+  std::mutex fRxMutex;
+
+  std::condition_variable fRxCondition;
+
+  static std::mutex fIoThreadMutex;
+
+  static unsigned int fIoThreadUsers;
+
+  static std::unique_ptr<boost::asio::io_service::work> fIoWork;
+
+  static std::thread fIoThread;
+
   //Can only be opened by DeviceManager, not by user
   virtual void Open(bool slowControlOnly);
 
@@ -0,0 +1,143 @@
+/**
+ * @file FragmentBufferPool.cxx
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_FRAGMENTBUFFERPOOL_CXX_
+#define SSPMODULES_SRC_ANLBOARD_FRAGMENTBUFFERPOOL_CXX_
+
+#include "FragmentBufferPool.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+dunedaq::sspmodules::FragmentBufferPool::FragmentBufferPool(unsigned int maxPooled, unsigned int reserveWords)
+  : fMaxPooled(maxPooled)
+  , fReserveWords(reserveWords)
+  , fNSizes(0)
+  , fHits(0)
+  , fMisses(0)
+{
+  std::fill(fSizes, fSizes + kNBuckets, 0);
+  fFree.reserve(fMaxPooled);
+}
+
+void
+dunedaq::sspmodules::FragmentBufferPool::Acquire(std::vector<unsigned int>& buffer, unsigned int nWords)
+{
+  unsigned int bucket = 0;
+  while (bucket < kNBuckets - 1 && (1u << bucket) < nWords) {
+    ++bucket;
+  }
+
+  std::unique_lock<std::mutex> lock(fMutex);
+  ++fSizes[bucket];
+  ++fNSizes;
+
+  if (buffer.capacity() >= nWords) {
+    ++fHits;
+    return;
+  }
+
+  // Take the last free buffer which is big enough
+  for (auto free = fFree.rbegin(); free != fFree.rend(); ++free) {
+    if (free->capacity() >= nWords) {
+      free->swap(buffer);
+      if (!free->capacity()) {
+        fFree.erase(std::next(free).base());
+      }
+      ++fHits;
+      return;
+    }
+  }
+  ++fMisses;
+  unsigned int reserveWords = std::max(nWords, this->TypicalWordsLocked());
+  lock.unlock();
+
+  std::vector<unsigned int> fresh;
+  fresh.reserve(reserveWords);
+  fresh.swap(buffer);
+
+  if (fresh.capacity()) {
+    lock.lock();
+    this->Recycle(std::move(fresh));
+  }
+}
+
+void
+dunedaq::sspmodules::FragmentBufferPool::Release(std::vector<unsigned int>&& buffer)
+{
+  if (!buffer.capacity()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(fMutex);
+  this->Recycle(std::move(buffer));
+}
+
+void
+dunedaq::sspmodules::FragmentBufferPool::Reserve(unsigned int nBuffers)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  unsigned int reserveWords = this->TypicalWordsLocked();
+  while (fFree.size() < nBuffers && fFree.size() < fMaxPooled) {
+    fFree.emplace_back();
+    fFree.back().reserve(reserveWords);
+  }
+}
+
+unsigned int
+dunedaq::sspmodules::FragmentBufferPool::TypicalWords()
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return this->TypicalWordsLocked();
+}
+
+unsigned int
+dunedaq::sspmodules::FragmentBufferPool::Available()
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fFree.size();
+}
+
+void
+dunedaq::sspmodules::FragmentBufferPool::Recycle(std::vector<unsigned int>&& buffer)
+{
+  buffer.clear();
+  if (fFree.size() < fMaxPooled) {
+    fFree.push_back(std::move(buffer));
+    return;
+  }
+
+  // Full up: keep the bigger of this and the smallest buffer held
+  auto smallest = std::min_element(
+    fFree.begin(), fFree.end(), [](const std::vector<unsigned int>& a, const std::vector<unsigned int>& b) {
+      return a.capacity() < b.capacity();
+    });
+  if (smallest != fFree.end() && smallest->capacity() < buffer.capacity()) {
+    smallest->swap(buffer);
+  }
+}
+
+unsigned int
+dunedaq::sspmodules::FragmentBufferPool::TypicalWordsLocked() const
+{
+  if (fNSizes < kMinSamples) {
+    return fReserveWords;
+  }
+  unsigned long threshold = fNSizes - fNSizes / 100; // NOLINT(runtime/int)
+  unsigned long seen = 0;                            // NOLINT(runtime/int)
+  unsigned int bucket = 0;
+  for (; bucket < kNBuckets - 1; ++bucket) {
+    seen += fSizes[bucket];
+    if (seen >= threshold) {
+      break;
+    }
+  }
+  return 1u << bucket;
+}
+
+#endif // SSPMODULES_SRC_ANLBOARD_FRAGMENTBUFFERPOOL_CXX_
@@ -0,0 +1,90 @@
+/**
+ * @file FragmentBufferPool.hpp
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_FRAGMENTBUFFERPOOL_HPP_
+#define SSPMODULES_SRC_ANLBOARD_FRAGMENTBUFFERPOOL_HPP_
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace dunedaq {
+namespace sspmodules {
+
+//Recycles the buffers fragments are built into, so that a burst of triggers
+//does not mean a burst of allocations. Fragment sizes vary with the number of
+//packets in the trigger window, so the pool keeps a histogram of the sizes it
+//has been asked for and allocates new buffers big enough for nearly all of
+//them; a fragment larger than any free buffer gets one of its own size.
+class FragmentBufferPool{
+
+public:
+
+  //maxPooled buffers are kept at most; until enough sizes have been seen new
+  //buffers start with reserveWords capacity
+  explicit FragmentBufferPool(unsigned int maxPooled = 64, unsigned int reserveWords = 4096);
+
+  //Make buffer hold at least nWords of capacity, swapping its storage for a
+  //free one (and keeping the old one) if it has too little. Contents are not kept.
+  void Acquire(std::vector<unsigned int>& buffer, unsigned int nWords);
+
+  //Hand a buffer back for reuse
+  void Release(std::vector<unsigned int>&& buffer);
+
+  //Preallocate buffers of the current typical size
+  void Reserve(unsigned int nBuffers);
+
+  //Capacity given to new buffers: the size bucket holding the 99th percentile
+  //of the fragments seen so far
+  unsigned int TypicalWords();
+
+  //Acquires served without / with an allocation
+  inline unsigned long Hits() const{ // NOLINT(runtime/int)
+    return fHits;
+  }
+
+  inline unsigned long Misses() const{ // NOLINT(runtime/int)
+    return fMisses;
+  }
+
+  //Number of buffers currently waiting to be reused
+  unsigned int Available();
+
+private:
+
+  //Fragment sizes, bucketed by the power of two above them
+  static const unsigned int kNBuckets = 32;
+
+  //Sizes seen before the histogram is trusted over reserveWords
+  static const unsigned long kMinSamples = 100; // NOLINT(runtime/int)
+
+  //Put back a buffer which has capacity; the caller holds fMutex
+  void Recycle(std::vector<unsigned int>&& buffer);
+
+  unsigned int TypicalWordsLocked() const;
+
+  std::mutex fMutex;
+
+  std::vector<std::vector<unsigned int>> fFree;
+
+  unsigned int fMaxPooled;
+
+  unsigned int fReserveWords;
+
+  unsigned long fSizes[kNBuckets];  // NOLINT(runtime/int)
+
+  unsigned long fNSizes;  // NOLINT(runtime/int)
+
+  std::atomic<unsigned long> fHits;   // NOLINT(runtime/int)
+
+  std::atomic<unsigned long> fMisses; // NOLINT(runtime/int)
+};
+
+} // namespace sspmodules
+} // namespace dunedaq
+
+#endif // SSPMODULES_SRC_ANLBOARD_FRAGMENTBUFFERPOOL_HPP_
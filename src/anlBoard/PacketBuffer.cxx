@@ -0,0 +1,171 @@
+/**
+ * @file PacketBuffer.cxx
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_PACKETBUFFER_CXX_
+#define SSPMODULES_SRC_ANLBOARD_PACKETBUFFER_CXX_
+
+#include "PacketBuffer.hpp"
+
+#include <utility>
+#include <vector>
+
+dunedaq::sspmodules::PacketBuffer::PacketBuffer(unsigned int initialCapacity)
+  : fHead(0)
+  , fSize(0)
+  , fMaxBytes(0)
+  , fMaxSpan(0)
+  , fPayloadBytes(0)
+{
+  unsigned int capacity = 1;
+  while (capacity < initialCapacity) {
+    capacity <<= 1;
+  }
+  fEntries.resize(capacity);
+  fMask = capacity - 1;
+  fRingBytes = fEntries.size() * sizeof(Entry);
+  this->ResetStats();
+}
+
+void
+dunedaq::sspmodules::PacketBuffer::SetLimits(unsigned long maxBytes, unsigned long maxSpan) // NOLINT(runtime/int)
+{
+  fMaxBytes = maxBytes;
+  fMaxSpan = maxSpan;
+  this->Evict();
+}
+
+void
+dunedaq::sspmodules::PacketBuffer::Push(EventPacket&& packet, unsigned long time) // NOLINT(runtime/int)
+{
+  if (fSize == fEntries.size()) {
+    this->Grow();
+  }
+
+  // Walk back past any newer packets to keep the ring in time order
+  unsigned int i = fSize;
+  while (i > 0 && this->Slot(i - 1).time > time) {
+    this->Slot(i) = std::move(this->Slot(i - 1));
+    --i;
+  }
+  fPayloadBytes += PayloadBytes(packet);
+  this->Slot(i).time = time;
+  this->Slot(i).packet = std::move(packet);
+  ++fSize;
+
+  this->Evict();
+  if (this->Footprint() > fHighWater) {
+    fHighWater = this->Footprint();
+  }
+}
+
+std::pair<unsigned int, unsigned int>
+dunedaq::sspmodules::PacketBuffer::Window(unsigned long startTime, unsigned long endTime) const // NOLINT(runtime/int)
+{
+  unsigned int first = this->LowerBound(startTime);
+  unsigned int last = endTime > startTime ? this->LowerBound(endTime) : first;
+  return std::make_pair(first, last);
+}
+
+unsigned int
+dunedaq::sspmodules::PacketBuffer::ReleaseBefore(unsigned long time) // NOLINT(runtime/int)
+{
+  unsigned int nReleased = this->LowerBound(time);
+  this->ReleaseFront(nReleased);
+  return nReleased;
+}
+
+void
+dunedaq::sspmodules::PacketBuffer::Clear()
+{
+  this->ReleaseFront(fSize);
+  fHead = 0;
+}
+
+void
+dunedaq::sspmodules::PacketBuffer::ResetStats()
+{
+  fHighWater = this->Footprint();
+  fEvicted = 0;
+  fEvictedBytes = 0;
+}
+
+unsigned long // NOLINT(runtime/int)
+dunedaq::sspmodules::PacketBuffer::ReleaseFront(unsigned int nPackets)
+{
+  unsigned long bytes = 0; // NOLINT(runtime/int)
+  for (unsigned int i = 0; i < nPackets; ++i) {
+    bytes += PayloadBytes(this->Slot(i).packet);
+    this->Slot(i).packet = EventPacket();
+  }
+  fHead = (fHead + nPackets) & fMask;
+  fSize -= nPackets;
+  fPayloadBytes -= bytes;
+  return bytes;
+}
+
+void
+dunedaq::sspmodules::PacketBuffer::Evict()
+{
+  // Find how far the limits reach into the buffer, then let go of it all at once.
+  // The newest packet is always kept.
+  unsigned int nEvict = 0;
+  if (fMaxSpan && fSize && this->LatestTime() > fMaxSpan) {
+    nEvict = this->LowerBound(this->LatestTime() - fMaxSpan);
+  }
+  if (fMaxBytes) {
+    unsigned long footprint = fRingBytes + fPayloadBytes; // NOLINT(runtime/int)
+    for (unsigned int i = 0; i < nEvict; ++i) {
+      footprint -= PayloadBytes(this->Slot(i).packet);
+    }
+    while (footprint > fMaxBytes && nEvict + 1 < fSize) {
+      footprint -= PayloadBytes(this->Slot(nEvict).packet);
+      ++nEvict;
+    }
+  }
+  if (nEvict) {
+    fEvictedBytes += this->ReleaseFront(nEvict);
+    fEvicted += nEvict;
+  }
+}
+
+unsigned int
+dunedaq::sspmodules::PacketBuffer::LowerBound(unsigned long time) const // NOLINT(runtime/int)
+{
+  unsigned int low = 0;
+  unsigned int high = fSize;
+  while (low < high) {
+    unsigned int mid = low + (high - low) / 2;
+    if (this->Slot(mid).time < time) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+void
+dunedaq::sspmodules::PacketBuffer::Grow()
+{
+  // Past the byte limit the ring itself would not fit; make room instead
+  if (fMaxBytes && (2 * fEntries.size() * sizeof(Entry)) > fMaxBytes && fSize > 1) {
+    fEvictedBytes += this->ReleaseFront(1);
+    ++fEvicted;
+    return;
+  }
+
+  std::vector<Entry> entries(fEntries.size() * 2);
+  for (unsigned int i = 0; i < fSize; ++i) {
+    entries[i] = std::move(this->Slot(i));
+  }
+  fEntries.swap(entries);
+  fMask = fEntries.size() - 1;
+  fHead = 0;
+  fRingBytes = fEntries.size() * sizeof(Entry);
+}
+
+#endif // SSPMODULES_SRC_ANLBOARD_PACKETBUFFER_CXX_
@@ -0,0 +1,149 @@
+/**
+ * @file PacketBuffer.hpp
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_PACKETBUFFER_HPP_
+#define SSPMODULES_SRC_ANLBOARD_PACKETBUFFER_HPP_
+
+#include "EventPacket.hpp"
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace sspmodules {
+
+//Event packets waiting to be built into fragments, held in a ring in
+//timestamp order together with their timestamps. The packets falling in a
+//trigger window are found by binary search, and old packets are released
+//from the front in bulk.
+//Packets are expected to arrive nearly in time order: one older than the
+//newest is moved back into place, at a cost of the number it passes.
+//Memory can be bounded by footprint and by time span; when a new packet takes
+//the buffer over either limit the oldest packets are evicted to make room.
+//Footprint and eviction counters may be read from any thread.
+class PacketBuffer{
+
+public:
+
+  explicit PacketBuffer(unsigned int initialCapacity = 1024);
+
+  //Limits on the footprint in bytes and on the ticks between the oldest and
+  //newest packet; 0 leaves that one unlimited
+  void SetLimits(unsigned long maxBytes, unsigned long maxSpan);  // NOLINT(runtime/int)
+
+  void Push(EventPacket&& packet, unsigned long time);  // NOLINT(runtime/int)
+
+  inline unsigned int Size() const{
+    return fSize;
+  }
+
+  inline bool Empty() const{
+    return fSize == 0;
+  }
+
+  //Timestamp of the newest packet. Only call on a non-empty buffer.
+  inline unsigned long LatestTime() const{  // NOLINT(runtime/int)
+    return this->Slot(fSize - 1).time;
+  }
+
+  //Positions [first, last) of the packets with timestamps in [startTime, endTime)
+  std::pair<unsigned int, unsigned int> Window(unsigned long startTime, unsigned long endTime) const;  // NOLINT(runtime/int)
+
+  //Packet at a position counted from the oldest
+  inline const EventPacket& At(unsigned int i) const{
+    return this->Slot(i).packet;
+  }
+
+  inline unsigned long TimeAt(unsigned int i) const{  // NOLINT(runtime/int)
+    return this->Slot(i).time;
+  }
+
+  //Release every packet older than time. Returns how many there were.
+  unsigned int ReleaseBefore(unsigned long time);  // NOLINT(runtime/int)
+
+  void Clear();
+
+  //Bytes held: the ring itself plus the payload buffers of the packets in it
+  inline unsigned long Footprint() const{  // NOLINT(runtime/int)
+    return fRingBytes + fPayloadBytes;
+  }
+
+  inline unsigned long HighWaterFootprint() const{  // NOLINT(runtime/int)
+    return fHighWater;
+  }
+
+  //Packets evicted to stay within the limits, rather than released after use
+  inline unsigned long EvictedPackets() const{  // NOLINT(runtime/int)
+    return fEvicted;
+  }
+
+  inline unsigned long EvictedBytes() const{  // NOLINT(runtime/int)
+    return fEvictedBytes;
+  }
+
+  void ResetStats();
+
+private:
+
+  struct Entry{
+    unsigned long time;  // NOLINT(runtime/int)
+    EventPacket packet;
+  };
+
+  static inline unsigned long PayloadBytes(const EventPacket& packet){  // NOLINT(runtime/int)
+    return packet.data.capacity() * sizeof(unsigned int);
+  }
+
+  //Release the oldest nPackets, freeing their payload buffers. Returns the bytes freed.
+  unsigned long ReleaseFront(unsigned int nPackets);  // NOLINT(runtime/int)
+
+  //Evict from the front until back within the limits
+  void Evict();
+
+  inline Entry& Slot(unsigned int i){
+    return fEntries[(fHead + i) & fMask];
+  }
+
+  inline const Entry& Slot(unsigned int i) const{
+    return fEntries[(fHead + i) & fMask];
+  }
+
+  //First position whose timestamp is not less than time
+  unsigned int LowerBound(unsigned long time) const;  // NOLINT(runtime/int)
+
+  //Double the capacity, moving the packets to the start of the new ring
+  void Grow();
+
+  //Capacity is a power of two
+  std::vector<Entry> fEntries;
+
+  unsigned int fMask;
+
+  unsigned int fHead;
+
+  unsigned int fSize;
+
+  unsigned long fMaxBytes;  // NOLINT(runtime/int)
+
+  unsigned long fMaxSpan;  // NOLINT(runtime/int)
+
+  std::atomic<unsigned long> fRingBytes;  // NOLINT(runtime/int)
+
+  std::atomic<unsigned long> fPayloadBytes;  // NOLINT(runtime/int)
+
+  std::atomic<unsigned long> fHighWater;  // NOLINT(runtime/int)
+
+  std::atomic<unsigned long> fEvicted;  // NOLINT(runtime/int)
+
+  std::atomic<unsigned long> fEvictedBytes;  // NOLINT(runtime/int)
+};
+
+} // namespace sspmodules
+} // namespace dunedaq
+
+#endif // SSPMODULES_SRC_ANLBOARD_PACKETBUFFER_HPP_
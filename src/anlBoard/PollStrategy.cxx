@@ -0,0 +1,113 @@
+/**
+ * @file PollStrategy.cxx
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_POLLSTRATEGY_CXX_
+#define SSPMODULES_SRC_ANLBOARD_POLLSTRATEGY_CXX_
+
+#include "PollStrategy.hpp"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+dunedaq::sspmodules::PollStrategy::PollStrategy()
+  : fSleeps(0)
+{
+  this->Reset();
+}
+
+void
+dunedaq::sspmodules::PollStrategy::Configure(const Settings& settings)
+{
+  fSettings = settings;
+  fSettings.minSleepInUs = std::max(fSettings.minSleepInUs, 1u);
+  fSettings.maxSleepInUs = std::max(fSettings.maxSleepInUs, fSettings.minSleepInUs);
+  this->Reset();
+}
+
+bool
+dunedaq::sspmodules::PollStrategy::Wait(Device* device, unsigned int nWords, unsigned int timeoutInUs)
+{
+  if (fSettings.mode == kDevice) {
+    return device->DeviceWaitForData(timeoutInUs);
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  auto deadline = now + std::chrono::microseconds(timeoutInUs);
+  if (!fIdle) {
+    fIdle = true;
+    fActiveAt = now;
+    fLastQueued = 0;
+    fSleepInUs = fSettings.minSleepInUs;
+  }
+
+  while (true) {
+    unsigned int queued = 0;
+    device->DeviceQueueStatus(&queued);
+    if (queued >= nWords) {
+      fIdle = false;
+      return true;
+    }
+
+    now = std::chrono::steady_clock::now();
+    // Part of what we need has turned up, so more is on its way: go back to spinning
+    if (queued > fLastQueued) {
+      fActiveAt = now;
+      fSleepInUs = fSettings.minSleepInUs;
+    }
+    fLastQueued = queued;
+
+    if (now >= deadline) {
+      return false;
+    }
+    if (fSettings.mode == kSpin) {
+      continue;
+    }
+
+    auto idleFor = now - fActiveAt;
+    if (idleFor < std::chrono::microseconds(fSettings.spinInUs)) {
+      continue;
+    }
+    if (idleFor < std::chrono::microseconds(fSettings.spinInUs + fSettings.yieldInUs)) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Sleep through the device, so that one which can be woken by arriving
+    // data (asynchronous receive, the emulator) is not left asleep
+    unsigned int remainingInUs =
+      std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count() + 1;
+    device->DeviceWaitForData(std::min(fSleepInUs, remainingInUs));
+    fSleepInUs = std::min(fSleepInUs * 2, fSettings.maxSleepInUs);
+    ++fSleeps;
+  }
+}
+
+void
+dunedaq::sspmodules::PollStrategy::Reset()
+{
+  fIdle = false;
+  fLastQueued = 0;
+  fSleepInUs = fSettings.minSleepInUs;
+}
+
+bool
+dunedaq::sspmodules::PollStrategy::ParseMode(const std::string& name, Mode_t& mode)
+{
+  if (name == "device") {
+    mode = kDevice;
+  } else if (name == "adaptive") {
+    mode = kAdaptive;
+  } else if (name == "spin") {
+    mode = kSpin;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+#endif // SSPMODULES_SRC_ANLBOARD_POLLSTRATEGY_CXX_
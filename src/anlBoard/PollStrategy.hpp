@@ -0,0 +1,84 @@
+/**
+ * @file PollStrategy.hpp
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_POLLSTRATEGY_HPP_
+#define SSPMODULES_SRC_ANLBOARD_POLLSTRATEGY_HPP_
+
+#include "Device.hpp"
+
+#include <chrono>
+#include <string>
+
+namespace dunedaq {
+namespace sspmodules {
+
+//How the readout thread waits for data from the board when it has run out.
+//kDevice hands the wait to Device::DeviceWaitForData, which blocks on a
+//condition variable for asynchronous receive and the emulator, but otherwise
+//polls every 100us. kAdaptive watches DeviceQueueStatus itself: it spins for
+//a short time after the last data arrived, then yields, then waits on the
+//device with a doubling timeout, so bursts are picked up at once without an
+//idle board costing a core. kSpin never sleeps.
+//Only to be used from one thread at a time.
+class PollStrategy{
+
+public:
+
+  enum Mode_t{kDevice,kAdaptive,kSpin};
+
+  struct Settings{
+    Mode_t mode = kAdaptive;
+    unsigned int spinInUs = 20;
+    unsigned int yieldInUs = 100;
+    unsigned int minSleepInUs = 10;
+    unsigned int maxSleepInUs = 1000;
+  };
+
+  PollStrategy();
+
+  void Configure(const Settings& settings);
+
+  inline const Settings& GetSettings() const{
+    return fSettings;
+  }
+
+  //Wait until at least nWords are queued on the device, or timeoutInUs has
+  //passed. Returns whether they are.
+  bool Wait(Device* device, unsigned int nWords, unsigned int timeoutInUs);
+
+  //Start again from spinning, e.g. at the start of a run
+  void Reset();
+
+  //Number of times the board was found idle for long enough to sleep
+  inline unsigned long Sleeps() const{  // NOLINT(runtime/int)
+    return fSleeps;
+  }
+
+  //Parse "device", "adaptive" or "spin". Returns false for anything else.
+  static bool ParseMode(const std::string& name, Mode_t& mode);
+
+private:
+
+  Settings fSettings;
+
+  //Whether the device has been waited on since it last had data
+  bool fIdle;
+
+  //When the device last had data, or more data than before
+  std::chrono::steady_clock::time_point fActiveAt;
+
+  unsigned int fLastQueued;
+
+  unsigned int fSleepInUs;
+
+  unsigned long fSleeps;  // NOLINT(runtime/int)
+};
+
+} // namespace sspmodules
+} // namespace dunedaq
+
+#endif // SSPMODULES_SRC_ANLBOARD_POLLSTRATEGY_HPP_
@@ -10,6 +10,11 @@
 
 #include "RegMap.hpp"
 
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
 dunedaq::sspmodules::RegMap&
 dunedaq::sspmodules::RegMap::Get(void)
 {
@@ -623,7 +628,7 @@ dunedaq::sspmodules::RegMap::Get(void)
     instance->fNamed["sync_delay"]              =Register(  0x80000498, 0xFFFFFFFF, 0x00000000, 1 );
     instance->fNamed["sync_count"]              =Register(  0x8000049C, 0xFFFFFFFF, 0x00000000, 1 ); 
     instance->fNamed["pdts_control"]            =Register(  0x800004C0, 0xFFFFFFFF, 0xFFFFFFFF, 1 );
-    instance->fNamed["pdts_status"]             =Register(  0x800004C4, 0x00000000, 0xFFFFFFFF, 1 );
+    instance->fNamed["pdts_status"]             =Register(  0x800004C4, 0xFFFFFFFF, 0x00000000, 1 );
     instance->fNamed["pdts_ts_preset"]          =Register(  0x800004C8, 0x00000000, 0xFFFFFFFF, 2 );
     instance->fNamed["master_logic_control"]    =Register(  0x80000500, 0xFFFFFFFF, 0x00000173, 1 );     
     instance->fNamed["master_logic_status"]     =Register(  0x80000504, 0x00000001, 0x00000000, 1 );
@@ -641,7 +646,97 @@ dunedaq::sspmodules::RegMap::Get(void)
     instance->fNamed["idelay_count"]            =Register(  0x80000800, 0xFFFFFFFF, 0x00000000, 12);
     instance->fNamed["adc_data_monitor"]        =Register(  0x80000840, 0x0000FFFF, 0x00000000, 12);     
     instance->fNamed["adc_status"]              =Register(  0x80000880, 0xFFFFFFFF, 0x00000000, 12);
+    instance->fNamed["pdts_cmd_delay"]          =Register(  0x80000940, 0xFFFFFFFF, 0xFFFFFFFF, 16);
+    instance->fNamed["cal_config"]              =Register(  0x800003C0, 0xFFFFFFFF, 0xFFFFFFFF, 12);
+    instance->fNamed["cal_count"]               =Register(  0x80000448, 0xFFFFFFFF, 0xFFFFFFFF, 1 );
+    // clang-format on
+
+    // Registers whose value is simply whatever was last written. Strobes, status,
+    // counters and anything the firmware updates by itself must not be listed here.
+    // pdts_cmd_control is left out: bit 31 of its elements is a command strobe,
+    // and writing the same value again must reach the board.
+    const char* configOnlyNames[] = { "channel_control", "led_threshold",      "cfd_parameters",
+                                      "readout_pretrigger", "readout_window",  "p_window",
+                                      "i2_window",       "m1_window",          "m2_window",
+                                      "d_window",        "i1_window",          "disc_width",
+                                      "baseline_start",  "c_window",           "trigger_input_delay",
+                                      "gpio_output_width", "front_panel_config", "baseline_delay",
+                                      "qi_config",       "qi_delay",           "qi_pulse_width",
+                                      "external_gate_width", "bias_config",    "pdts_cmd_delay",
+                                      "cal_config",      "cal_count" };
+    for (const char* name : configOnlyNames) {
+      Register& reg = instance->fNamed[name];
+      reg.SetConfigOnly();
+      for (unsigned int i = 0; i < reg.Size(); ++i) {
+        Register element(reg.Address() + 0x4 * i, reg.ReadMask(), reg.WriteMask());
+        element.SetConfigOnly();
+        instance->fConfigOnly[element.Address()] = element;
+      }
+    }
+
+    // Non-zero power-up values, from the table of scalar registers above. Where
+    // one value is given for an array it applies to every element.
+    // clang-format off
+    const std::pair<const char*, std::vector<unsigned int>> defaults[] = {
+      { "armStatus",          { 0xABCDEF01 } },
+      { "armError",           { 0xEF012345 } },
+      { "armVersion",         { 0x00000001 } },
+      { "armTest",            { 0x12345678, 0x567890AB, 0x90ABCDEF, 0xCDEF1234 } },
+      { "armRxAddress",       { 0xFFFFFFF0 } },
+      { "armRxCommand",       { 0xFFFFFFF1 } },
+      { "armRxSize",          { 0xFFFFFFF2 } },
+      { "armRxStatus",        { 0xFFFFFFF3 } },
+      { "armTxAddress",       { 0xFFFFFFF4 } },
+      { "armTxCommand",       { 0xFFFFFFF5 } },
+      { "armTxSize",          { 0xFFFFFFF6 } },
+      { "armTxStatus",        { 0xFFFFFFF7 } },
+      { "zynqTest",           { 0x33333333, 0x44444444, 0x55555555, 0x66666666, 0x00000000, 0x00000000 } },
+      { "eventDataControl",   { 0x0020001F } },
+      { "c2c_control",        { 0x00000007 } },
+      { "comm_clock_control", { 0x00000001 } },
+      { "qi_dac_config",      { 0x00008000 } },
+      { "vmon_config",        { 0x0012F000 } },
+      { "vmon_select",        { 0x00FFFF00 } },
+      { "imon_config",        { 0x0012F000 } },
+      { "imon_select",        { 0x00FFFF00 } },
+      { "led_threshold",      { 0x00000064 } },
+      { "cfd_parameters",     { 0x00001800 } },
+      { "readout_pretrigger", { 0x00000019 } },
+      { "readout_window",     { 0x000000C8 } },
+      { "i2_window",          { 0x00000014 } },
+      { "m1_window",          { 0x0000000A } },
+      { "m2_window",          { 0x00000014 } },
+      { "d_window",           { 0x00000014 } },
+      { "i1_window",          { 0x00000010 } },
+      { "baseline_start",     { 0x00002000 } },
+      { "c_window",           { 0x00002000 } },
+      { "trigger_input_delay",{ 0x00000010 } },
+      { "gpio_output_width",  { 0x0000000F } },
+      { "front_panel_config", { 0x00000111 } },
+      { "baseline_delay",     { 0x00000019 } },
+      { "event_data_control", { 0x00000001 } },
+      { "adc_config",         { 0x00010000 } },
+      { "qi_config",          { 0x0FFF1700 } },
+      { "external_gate_width",{ 0x00008000 } },
+    };
     // clang-format on
+    std::map<std::string, const std::vector<unsigned int>*> defaultValues;
+    for (const auto& def : defaults) {
+      defaultValues[def.first] = &def.second;
+    }
+
+    for (auto named = instance->fNamed.begin(); named != instance->fNamed.end(); ++named) {
+      const Register& reg = named->second;
+      auto def = defaultValues.find(named->first);
+      for (unsigned int i = 0; i < reg.Size(); ++i) {
+        Register element(reg.Address() + 0x4 * i, reg.ReadMask(), reg.WriteMask());
+        element.SetConfigOnly(reg.ConfigOnly());
+        if (def != defaultValues.end()) {
+          element.SetDefault(def->second->size() == 1 ? def->second->front() : def->second->at(i));
+        }
+        instance->fByAddress[element.Address()] = element;
+      }
+    }
   }
   return *instance;
 } // NOLINT(readability/fn_size)
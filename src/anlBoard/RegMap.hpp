@@ -64,6 +64,10 @@ public:
 
     //Getters and setters
 
+    inline unsigned int Address() const{
+      return fAddress;
+    }
+
     inline unsigned int ReadMask() const{
       return fReadMask;
     }
@@ -84,6 +88,26 @@ public:
       return fSize;
     }
 
+    //Configuration-only registers hold exactly what software last wrote
+    //to them, and writing them has no side effects. Devices may keep a
+    //shadow copy of these and skip redundant accesses.
+    inline bool ConfigOnly() const{
+      return fConfigOnly;
+    }
+
+    inline void SetConfigOnly(bool configOnly=true){
+      fConfigOnly = configOnly;
+    }
+
+    //Value of the register after the board is powered up or reset
+    inline unsigned int Default() const{
+      return fDefault;
+    }
+
+    inline void SetDefault(unsigned int value){
+      fDefault = value;
+    }
+
   private:
 
     //Address of register in SSP space
@@ -103,6 +127,10 @@ public:
 
     //Number of bits assigned to relevant quantity. Not currently used (see above)
     unsigned int fBits {32};
+
+    bool fConfigOnly {false};
+
+    unsigned int fDefault {0x00000000};
   };
 
   //Get registers using variable names...
@@ -115,6 +143,20 @@ public:
     return fNamed[name];
   }
 
+  //Get the configuration-only register at a given address (array elements
+  //are indexed individually). Returns 0 for any other address.
+  const Register* FindConfigOnly(unsigned int address) const{
+    auto reg = fConfigOnly.find(address);
+    return reg == fConfigOnly.end() ? 0 : &(reg->second);
+  }
+
+  //Get the named register at a given address, with size 1 and the default
+  //value of that element. Returns 0 for addresses which are not named.
+  const Register* Find(unsigned int address) const{
+    auto reg = fByAddress.find(address);
+    return reg == fByAddress.end() ? 0 : &(reg->second);
+  }
+
   // Registers in the ARM Processor
   unsigned int armStatus;
   unsigned int armError;
@@ -271,6 +313,12 @@ private:
   RegMap(RegMap&&) = delete;
   RegMap& operator=(RegMap&&) = delete;
   std::map<std::string, Register> fNamed;
+
+  //Element address -> register, for registers flagged as configuration-only
+  std::map<unsigned int, Register> fConfigOnly;
+
+  //Element address -> register, for all named registers
+  std::map<unsigned int, Register> fByAddress;
 };
 
 } // namespace sspmodules
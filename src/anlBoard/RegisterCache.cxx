@@ -0,0 +1,79 @@
+/**
+ * @file RegisterCache.cxx
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_REGISTERCACHE_CXX_
+#define SSPMODULES_SRC_ANLBOARD_REGISTERCACHE_CXX_
+
+#include "RegisterCache.hpp"
+
+dunedaq::sspmodules::RegisterCache::RegisterCache()
+  : fRegMap(RegMap::Get())
+  , fSkippedWrites(0)
+  , fCachedReads(0)
+{}
+
+bool
+dunedaq::sspmodules::RegisterCache::Lookup(unsigned int address, unsigned int& value)
+{
+  auto cached = fValues.find(address);
+  if (cached == fValues.end()) {
+    return false;
+  }
+  value = cached->second & fRegMap.FindConfigOnly(address)->ReadMask();
+  ++fCachedReads;
+  return true;
+}
+
+bool
+dunedaq::sspmodules::RegisterCache::Unchanged(unsigned int address, unsigned int value, unsigned int mask) const
+{
+  auto cached = fValues.find(address);
+  if (cached == fValues.end()) {
+    return false;
+  }
+  unsigned int writeMask = fRegMap.FindConfigOnly(address)->WriteMask() & mask;
+  return ((cached->second ^ value) & writeMask) == 0;
+}
+
+void
+dunedaq::sspmodules::RegisterCache::Store(unsigned int address, unsigned int value)
+{
+  if (this->Cacheable(address)) {
+    fValues[address] = value;
+  }
+}
+
+void
+dunedaq::sspmodules::RegisterCache::StoreMasked(unsigned int address, unsigned int mask, unsigned int value)
+{
+  const RegMap::Register* reg = fRegMap.FindConfigOnly(address);
+  if (!reg) {
+    return;
+  }
+
+  auto cached = fValues.find(address);
+  if (cached != fValues.end()) {
+    cached->second = (cached->second & ~mask) | (value & mask);
+  } else if ((reg->WriteMask() & ~mask) == 0) {
+    // Every writable bit was covered by the mask, so the value is fully known
+    fValues[address] = value & mask;
+  }
+}
+
+void
+dunedaq::sspmodules::RegisterCache::Invalidate(unsigned int address)
+{
+  fValues.erase(address);
+}
+
+void
+dunedaq::sspmodules::RegisterCache::Clear()
+{
+  fValues.clear();
+}
+
+#endif // SSPMODULES_SRC_ANLBOARD_REGISTERCACHE_CXX_
@@ -0,0 +1,85 @@
+/**
+ * @file RegisterCache.hpp
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_REGISTERCACHE_HPP_
+#define SSPMODULES_SRC_ANLBOARD_REGISTERCACHE_HPP_
+
+#include "RegMap.hpp"
+
+#include <unordered_map>
+
+namespace dunedaq {
+namespace sspmodules {
+
+//Shadow copy of the configuration-only registers of one device (see
+//RegMap::Register::ConfigOnly). Devices consult it before going to the
+//hardware so that rewriting an unchanged value, or reading back a value
+//we set ourselves, does not cost a round trip. Other addresses are never
+//cached.
+class RegisterCache{
+
+public:
+
+  RegisterCache();
+
+  //Whether the register at address may be cached at all
+  inline bool Cacheable(unsigned int address) const{
+    return fRegMap.FindConfigOnly(address) != 0;
+  }
+
+  //Get the cached value of a register, as DeviceRead would return it.
+  //Returns false if the value is not known.
+  bool Lookup(unsigned int address, unsigned int& value);
+
+  //Whether the value of a register is known
+  inline bool Known(unsigned int address) const{
+    return fValues.count(address) != 0;
+  }
+
+  //Whether writing value would leave the writable bits of the register
+  //that are high in mask unchanged
+  bool Unchanged(unsigned int address, unsigned int value, unsigned int mask=0xFFFFFFFF) const;
+
+  //Record a value written to or read from the hardware
+  void Store(unsigned int address, unsigned int value);
+
+  //Record a masked write. If the other bits are not known the register is forgotten.
+  void StoreMasked(unsigned int address, unsigned int mask, unsigned int value);
+
+  //Forget a single register, e.g. after a failed write
+  void Invalidate(unsigned int address);
+
+  //Forget everything, e.g. after (re)connecting to the board
+  void Clear();
+
+  inline unsigned long SkippedWrites() const{ // NOLINT(runtime/int)
+    return fSkippedWrites;
+  }
+
+  inline unsigned long CachedReads() const{ // NOLINT(runtime/int)
+    return fCachedReads;
+  }
+
+  inline void CountSkippedWrites(unsigned int n=1){
+    fSkippedWrites += n;
+  }
+
+private:
+
+  RegMap& fRegMap;
+
+  std::unordered_map<unsigned int, unsigned int> fValues;
+
+  unsigned long fSkippedWrites; // NOLINT(runtime/int)
+
+  unsigned long fCachedReads;   // NOLINT(runtime/int)
+};
+
+} // namespace sspmodules
+} // namespace dunedaq
+
+#endif // SSPMODULES_SRC_ANLBOARD_REGISTERCACHE_HPP_
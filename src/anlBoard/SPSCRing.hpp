@@ -0,0 +1,112 @@
+/**
+ * @file SPSCRing.hpp
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef SSPMODULES_SRC_ANLBOARD_SPSCRING_HPP_
+#define SSPMODULES_SRC_ANLBOARD_SPSCRING_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace dunedaq {
+namespace sspmodules {
+
+// Bounded lock-free ring for exactly one producer thread and one consumer
+// thread. Elements are preallocated and filled/drained in place, so element
+// types holding buffers (e.g. EventPacket) keep their capacity between uses.
+template <typename T>
+class SPSCRing
+{
+public:
+
+  explicit SPSCRing(size_t capacity)
+    : buffer_(capacity + 1)
+    , head_(0)
+    , tail_(0)
+    , high_water_(0)
+    , overruns_(0)
+  {}
+
+  SPSCRing(const SPSCRing&) = delete;            // disable copying
+  SPSCRing& operator=(const SPSCRing&) = delete; // disable assignment
+
+  // Producer: next free element, or nullptr if the ring is full
+  T* write_slot()
+  {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (next(tail) == head_.load(std::memory_order_acquire))
+      return nullptr;
+    return &buffer_[tail];
+  }
+
+  // Producer: publish the element returned by write_slot()
+  void commit_write()
+  {
+    tail_.store(next(tail_.load(std::memory_order_relaxed)), std::memory_order_release);
+    size_t fill = size();
+    if (fill > high_water_.load(std::memory_order_relaxed))
+      high_water_.store(fill, std::memory_order_relaxed);
+  }
+
+  // Producer: count an element dropped because the ring was full
+  void record_overrun() { overruns_.fetch_add(1, std::memory_order_relaxed); }
+
+  // Consumer: oldest published element, or nullptr if the ring is empty
+  T* read_slot()
+  {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return nullptr;
+    return &buffer_[head];
+  }
+
+  // Consumer: hand the element returned by read_slot() back to the producer
+  void commit_read()
+  {
+    head_.store(next(head_.load(std::memory_order_relaxed)), std::memory_order_release);
+  }
+
+  // Current fill level; only approximate while both sides are active
+  size_t size() const
+  {
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    return tail >= head ? tail - head : tail + buffer_.size() - head;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  size_t capacity() const { return buffer_.size() - 1; }
+
+  size_t high_water() const { return high_water_.load(std::memory_order_relaxed); }
+
+  unsigned long overruns() const { return overruns_.load(std::memory_order_relaxed); } // NOLINT(runtime/int)
+
+  // Reset counters; only call while neither side is active
+  void reset_stats()
+  {
+    high_water_.store(0, std::memory_order_relaxed);
+    overruns_.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  size_t next(size_t index) const { return index + 1 == buffer_.size() ? 0 : index + 1; }
+
+  std::vector<T> buffer_;
+
+  // Consumer and producer positions on separate cache lines
+  alignas(64) std::atomic<size_t> head_;
+  alignas(64) std::atomic<size_t> tail_;
+
+  std::atomic<size_t> high_water_;
+  std::atomic<unsigned long> overruns_; // NOLINT(runtime/int)
+};
+
+} // namespace sspmodules
+} // namespace dunedaq
+
+#endif // SSPMODULES_SRC_ANLBOARD_SPSCRING_HPP_
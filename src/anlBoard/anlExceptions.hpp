@@ -86,6 +86,18 @@ public:
   {}
 };
 
+//================================================//
+// TCP transaction not completed before its deadline//
+//================================================//
+
+class ETCPTimeout : public ETCPError
+{
+public:
+  explicit ETCPTimeout(const std::string& s)
+    : ETCPError(s)
+  {}
+};
+
 //===============================================//
 // Error receiving expected event data from device//
 //===============================================//
@@ -0,0 +1,255 @@
+/**
+ * @file ssp_board_simulator.cxx
+ *
+ * Stand-in for an SSP board on the network, so that EthernetDevice can be
+ * exercised end to end without hardware. Listens on the control (55001),
+ * slow control (55002) and data (55010) ports, answers CtrlPacket commands
+ * from the register file of an EmulatedDevice, and streams its events on the
+ * data socket while a run is started through master_logic_control.
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "anlBoard/DeviceManager.hpp"
+#include "anlBoard/EmulatedDevice.hpp"
+
+#include "fddetdataformats/SSPTypes.hpp"
+
+#include "boost/asio.hpp"
+#include "boost/program_options.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace po = boost::program_options;
+namespace ssp = dunedaq::fddetdataformats::ssp;
+
+using boost::asio::ip::tcp;
+
+namespace {
+
+const unsigned int header_size = sizeof(ssp::CtrlHeader);
+
+// Fill in the reply to one control request. Returns the reply length in bytes.
+unsigned int
+handle_command(dunedaq::sspmodules::EmulatedDevice& board, const ssp::CtrlPacket& tx, ssp::CtrlPacket& rx)
+{
+  rx.header.address = tx.header.address;
+  rx.header.command = tx.header.command;
+  rx.header.size = tx.header.size;
+  rx.header.status = ssp::statusNoError;
+  rx.header.length = header_size;
+
+  unsigned int payload_words = (tx.header.length - header_size) / sizeof(unsigned int);
+
+  switch (tx.header.command) {
+    case ssp::cmdRead:
+      board.DeviceRead(tx.header.address, &rx.data[0]);
+      rx.header.length += sizeof(unsigned int);
+      break;
+    case ssp::cmdReadMask:
+      if (payload_words < 1) {
+        rx.header.status = ssp::statusSizeError;
+        break;
+      }
+      board.DeviceReadMask(tx.header.address, tx.data[0], &rx.data[0]);
+      rx.header.length += sizeof(unsigned int);
+      break;
+    case ssp::cmdWrite:
+      if (payload_words < 1) {
+        rx.header.status = ssp::statusSizeError;
+        break;
+      }
+      board.DeviceWrite(tx.header.address, tx.data[0]);
+      break;
+    case ssp::cmdWriteMask:
+      if (payload_words < 2) {
+        rx.header.status = ssp::statusSizeError;
+        break;
+      }
+      board.DeviceWriteMask(tx.header.address, tx.data[0], tx.data[1]);
+      board.DeviceRead(tx.header.address, &rx.data[0]);
+      rx.header.length += sizeof(unsigned int);
+      break;
+    case ssp::cmdArrayRead:
+      if (tx.header.size > ssp::max_control_data) {
+        rx.header.status = ssp::statusSizeError;
+        break;
+      }
+      board.DeviceArrayRead(tx.header.address, tx.header.size, &rx.data[0]);
+      rx.header.length += tx.header.size * sizeof(unsigned int);
+      break;
+    case ssp::cmdFifoRead:
+      if (tx.header.size > ssp::max_control_data) {
+        rx.header.status = ssp::statusSizeError;
+        break;
+      }
+      for (unsigned int i = 0; i < tx.header.size; ++i) {
+        board.DeviceRead(tx.header.address, &rx.data[i]);
+      }
+      rx.header.length += tx.header.size * sizeof(unsigned int);
+      break;
+    case ssp::cmdArrayWrite:
+      if (tx.header.size > payload_words) {
+        rx.header.status = ssp::statusSizeError;
+        break;
+      }
+      board.DeviceArrayWrite(tx.header.address, tx.header.size, const_cast<unsigned int*>(&tx.data[0]));
+      break;
+    default:
+      rx.header.status = ssp::statusCommandError;
+      break;
+  }
+  return rx.header.length;
+}
+
+// Answer control requests on one connection until the client goes away
+void
+serve_control(dunedaq::sspmodules::EmulatedDevice& board, tcp::socket socket, std::atomic<unsigned long>& n_commands) // NOLINT(runtime/int)
+{
+  ssp::CtrlPacket tx;
+  ssp::CtrlPacket rx;
+  try {
+    while (true) {
+      boost::asio::read(socket, boost::asio::buffer(static_cast<void*>(&tx), header_size));
+      if (tx.header.length < header_size || tx.header.length > sizeof(ssp::CtrlPacket)) {
+        std::cerr << "Bad control packet length " << tx.header.length << ", dropping connection" << std::endl;
+        return;
+      }
+      if (tx.header.length > header_size) {
+        boost::asio::read(socket, boost::asio::buffer(static_cast<void*>(&tx.data[0]), tx.header.length - header_size));
+      }
+      unsigned int rx_size = handle_command(board, tx, rx);
+      boost::asio::write(socket, boost::asio::buffer(static_cast<void*>(&rx), rx_size));
+      ++n_commands;
+    }
+  } catch (const boost::system::system_error& ex) {
+    if (ex.code() != boost::asio::error::eof) {
+      std::cerr << "Control connection ended: " << ex.what() << std::endl;
+    }
+  }
+}
+
+// Stream event data to one connection until the client goes away
+void
+serve_data(dunedaq::sspmodules::EmulatedDevice& board, tcp::socket socket, unsigned int block_words)
+{
+  std::vector<unsigned int> words;
+  try {
+    while (true) {
+      board.DeviceReceive(words, block_words);
+      if (!words.empty()) {
+        boost::asio::write(socket, boost::asio::buffer(words));
+      }
+    }
+  } catch (const boost::system::system_error& ex) {
+    std::cerr << "Data connection ended: " << ex.what() << std::endl;
+  }
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  std::string bind_address = "127.0.0.1";
+  unsigned int device_id = 0;
+  double rate = 1000.;
+  unsigned int payload_words = 100;
+  unsigned int n_channels = 12;
+  unsigned int latency_us = 0;
+  int pdts_lock_us = -1;
+  unsigned int block_words = 16384;
+
+  po::options_description desc("Simulate an SSP board on the control/data TCP ports used by EthernetDevice");
+  desc.add_options()("help,h", "Print this help")(
+    "bind,b", po::value<std::string>(&bind_address)->default_value(bind_address), "Address to listen on")(
+    "device,n", po::value<unsigned int>(&device_id)->default_value(device_id), "Emulated device number")(
+    "rate,r", po::value<double>(&rate)->default_value(rate), "Mean aggregate event rate in Hz while running")(
+    "payload,p", po::value<unsigned int>(&payload_words)->default_value(payload_words), "Payload words per event")(
+    "channels,c", po::value<unsigned int>(&n_channels)->default_value(n_channels), "Number of channels to spread events over")(
+    "latency,l", po::value<unsigned int>(&latency_us)->default_value(latency_us), "Extra time per register access, in us")(
+    "pdts-lock,t", po::value<int>(&pdts_lock_us)->default_value(pdts_lock_us),
+    "Model timing endpoint sync, locking this many us after release (-1: always in sync)")(
+    "block,k", po::value<unsigned int>(&block_words)->default_value(block_words), "Largest data write in words");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  } catch (const po::error& ex) {
+    std::cerr << ex.what() << std::endl << desc << std::endl;
+    return 1;
+  }
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return 0;
+  }
+
+  auto board = dynamic_cast<dunedaq::sspmodules::EmulatedDevice*>(
+    dunedaq::sspmodules::DeviceManager::Get().OpenDevice(ssp::kEmulated, device_id));
+  if (!board) {
+    std::cerr << "Device " << device_id << " is not an emulated device" << std::endl;
+    return 1;
+  }
+  board->SetEventRate(rate);
+  board->SetPayloadWords(payload_words);
+  board->SetNChannels(n_channels);
+  board->SetAccessLatency(latency_us);
+  board->SetPdtsModel(pdts_lock_us >= 0, pdts_lock_us >= 0 ? pdts_lock_us : 0);
+
+  std::atomic<unsigned long> n_commands(0); // NOLINT(runtime/int)
+  boost::asio::io_service io_service;
+
+  std::unique_ptr<tcp::acceptor> control_acceptor;
+  std::unique_ptr<tcp::acceptor> slow_control_acceptor;
+  std::unique_ptr<tcp::acceptor> data_acceptor;
+  try {
+    auto address = boost::asio::ip::address::from_string(bind_address);
+    control_acceptor.reset(new tcp::acceptor(io_service, tcp::endpoint(address, 55001)));
+    slow_control_acceptor.reset(new tcp::acceptor(io_service, tcp::endpoint(address, 55002)));
+    data_acceptor.reset(new tcp::acceptor(io_service, tcp::endpoint(address, 55010)));
+  } catch (const boost::system::system_error& ex) {
+    std::cerr << "Could not listen on " << bind_address << ": " << ex.what() << std::endl;
+    return 1;
+  }
+
+  // One thread per port accepting connections and serving them in turn,
+  // so each port has at most one client at a time
+  auto listen = [&](tcp::acceptor* acceptor, bool data) {
+    while (true) {
+      tcp::socket socket(io_service);
+      acceptor->accept(socket);
+      socket.set_option(tcp::no_delay(true));
+      std::cout << "Accepted connection on port " << acceptor->local_endpoint().port() << std::endl;
+      if (data) {
+        serve_data(*board, std::move(socket), block_words);
+      } else {
+        serve_control(*board, std::move(socket), n_commands);
+      }
+    }
+  };
+
+  std::vector<std::thread> listeners;
+  listeners.emplace_back(listen, control_acceptor.get(), false);
+  listeners.emplace_back(listen, slow_control_acceptor.get(), false);
+  listeners.emplace_back(listen, data_acceptor.get(), true);
+
+  std::cout << "SSP board simulator listening on " << bind_address << " ports 55001, 55002 and 55010" << std::endl;
+
+  while (true) {
+    std::this_thread::sleep_for(std::chrono::seconds(10));
+    std::cout << n_commands << " control commands served, " << board->GeneratedEvents() << " events generated, "
+              << board->OverflowEvents() << " lost on buffer overflow" << std::endl;
+  }
+
+  return 0;
+}
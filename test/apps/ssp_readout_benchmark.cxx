@@ -0,0 +1,168 @@
+/**
+ * @file ssp_readout_benchmark.cxx
+ *
+ * Drive the DeviceInterface readout path (HardwareReadLoop and DispatchLoop)
+ * from an emulated board generating events at a given rate, and report
+ * throughput, CPU cost and the latency from event generation to dispatch.
+ * No sink queues are configured, so frames are counted and dropped at the
+ * end of the dispatch thread.
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "anlBoard/DeviceInterface.hpp"
+#include "anlBoard/EmulatedDevice.hpp"
+
+#include "fddetdataformats/SSPTypes.hpp"
+#include "fdreadoutlibs/SSPFrameTypeAdapter.hpp"
+
+#include "boost/program_options.hpp"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace po = boost::program_options;
+
+namespace {
+
+// Emulated event timestamps are 150MHz steady clock ticks; HardwareReadLoop
+// divides them by 3 on the way through
+using dispatch_ticks_t = std::chrono::duration<unsigned long, std::ratio<1, 50000000>>; // NOLINT(runtime/int)
+
+double
+cpu_seconds()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + 1e-6 * (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+unsigned long // NOLINT(runtime/int)
+percentile(const std::vector<unsigned long>& sorted, double fraction) // NOLINT(runtime/int)
+{
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  double duration = 10.;
+  unsigned int device_id = 0;
+  double rate = 100000.;
+  unsigned int payload_words = 100;
+  unsigned int n_channels = 12;
+  std::string poll_strategy = "adaptive";
+
+  po::options_description desc("Benchmark the SSP readout path against an emulated board");
+  desc.add_options()("help,h", "Print this help")(
+    "duration,d", po::value<double>(&duration)->default_value(duration), "Length of the run in seconds")(
+    "device,n", po::value<unsigned int>(&device_id)->default_value(device_id), "Emulated device number")(
+    "rate,r", po::value<double>(&rate)->default_value(rate), "Mean aggregate event rate in Hz")(
+    "payload,p", po::value<unsigned int>(&payload_words)->default_value(payload_words), "Payload words per event")(
+    "channels,c", po::value<unsigned int>(&n_channels)->default_value(n_channels), "Number of channels to spread events over")(
+    "poll,m", po::value<std::string>(&poll_strategy)->default_value(poll_strategy),
+    "How the read thread waits for data: adaptive, spin or device")(
+    "device-stats,s", "Also print the call counts and latencies of the device operations");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  } catch (const po::error& ex) {
+    std::cerr << ex.what() << std::endl << desc << std::endl;
+    return 1;
+  }
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return 0;
+  }
+
+  dunedaq::sspmodules::PollStrategy::Settings poll_settings;
+  if (!dunedaq::sspmodules::PollStrategy::ParseMode(poll_strategy, poll_settings.mode)) {
+    std::cerr << "Unknown poll strategy " << poll_strategy << std::endl << desc << std::endl;
+    return 1;
+  }
+
+  dunedaq::sspmodules::DeviceInterface device_interface(dunedaq::fddetdataformats::ssp::kEmulated);
+  device_interface.SetFragmentTimestampOffset(0);
+  device_interface.SetPollStrategy(poll_settings);
+
+  // Only touched from the dispatch thread until it has been joined by Stop
+  unsigned long n_events = 0; // NOLINT(runtime/int)
+  unsigned long n_bytes = 0;  // NOLINT(runtime/int)
+  std::vector<unsigned long> latencies_ns; // NOLINT(runtime/int)
+  latencies_ns.reserve(1 << 20);
+
+  device_interface.SetDispatchCallback([&](const dunedaq::fdreadoutlibs::types::SSPFrameTypeAdapter& frame) {
+    unsigned long now = // NOLINT(runtime/int)
+      std::chrono::duration_cast<dispatch_ticks_t>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    unsigned long event_time = 0; // NOLINT(runtime/int)
+    for (unsigned int iWord = 0; iWord <= 3; ++iWord) {
+      event_time += ((unsigned long)(frame.header.timestamp[iWord])) << 16 * iWord; // NOLINT(runtime/int)
+    }
+    ++n_events;
+    n_bytes += frame.header.length * sizeof(unsigned int);
+    latencies_ns.push_back(now > event_time ? (now - event_time) * 20 : 0);
+  });
+
+  device_interface.Open();
+  auto emulator = dynamic_cast<dunedaq::sspmodules::EmulatedDevice*>(device_interface.GetDevice());
+  if (!emulator) {
+    std::cerr << "Opened device is not an emulated device" << std::endl;
+    device_interface.Shutdown();
+    return 1;
+  }
+  emulator->SetEventRate(rate);
+  emulator->SetPayloadWords(payload_words);
+  emulator->SetNChannels(n_channels);
+  device_interface.Stop();
+
+  double cpu_start = cpu_seconds();
+  auto wall_start = std::chrono::steady_clock::now();
+  device_interface.Start();
+  std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+  device_interface.Stop();
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+  double cpu = cpu_seconds() - cpu_start;
+  device_interface.Shutdown();
+
+  std::sort(latencies_ns.begin(), latencies_ns.end());
+
+  std::printf("events:            %lu in %.3f s\n", n_events, wall);
+  std::printf("rate:              %.1f events/s, %.3f MB/s\n", n_events / wall, n_bytes / wall / 1e6);
+  std::printf("cpu (process):     %.3f s, %.3f us/event\n", cpu, n_events ? 1e6 * cpu / n_events : 0.);
+  std::printf("latency to dispatch: p50 %lu ns, p99 %lu ns, p99.9 %lu ns, max %lu ns\n",
+              percentile(latencies_ns, 0.5),
+              percentile(latencies_ns, 0.99),
+              percentile(latencies_ns, 0.999),
+              latencies_ns.empty() ? 0 : latencies_ns.back());
+  std::printf("generated:         %lu events, %lu lost on emulator buffer overflow\n",
+              emulator->GeneratedEvents(),
+              emulator->OverflowEvents());
+  std::printf("dropped:           %lu on ring overrun, %lu truncated\n",
+              device_interface.FrameRing().overruns(),
+              device_interface.TruncatedFrames());
+
+  if (vm.count("device-stats")) {
+    std::printf("\n");
+    std::fflush(stdout);
+    device_interface.DumpDeviceStats(std::cout);
+  }
+
+  return 0;
+}
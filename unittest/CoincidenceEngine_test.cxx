@@ -0,0 +1,131 @@
+/**
+ * @file CoincidenceEngine_test.cxx CoincidenceEngine class Unit Tests
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "anlBoard/CoincidenceEngine.hpp"
+
+#define BOOST_TEST_MODULE CoincidenceEngine_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+using namespace dunedaq::sspmodules;
+
+BOOST_AUTO_TEST_SUITE(CoincidenceEngine_test)
+
+BOOST_AUTO_TEST_CASE(CoincidentPacketsShareAWindow)
+{
+  CoincidenceEngine engine(12, 1000);
+
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(0, 10000, 1), CoincidenceEngine::kNewTrigger);
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(1, 10500, 1), CoincidenceEngine::kCoincident);
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(2, 9500, 1), CoincidenceEngine::kCoincident);
+  BOOST_REQUIRE_EQUAL(engine.OpenWindows(), 1);
+  BOOST_REQUIRE_EQUAL(engine.ChannelsSeen(10000), 0x7);
+
+  // A channel the window has already seen opens a window of its own
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(1, 10600, 1), CoincidenceEngine::kNewTrigger);
+  BOOST_REQUIRE_EQUAL(engine.OpenWindows(), 2);
+  BOOST_REQUIRE_EQUAL(engine.ChannelsSeen(10600), 0x2);
+
+  // As does a packet further than the window from every open one
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(3, 11601, 1), CoincidenceEngine::kNewTrigger);
+  BOOST_REQUIRE_EQUAL(engine.ChannelsSeen(12345), 0);
+}
+
+BOOST_AUTO_TEST_CASE(OverlappingWindows)
+{
+  CoincidenceEngine engine(12, 1000);
+
+  engine.AddTrigger(0, 10000, 1);
+  engine.AddTrigger(0, 10600, 1);
+  BOOST_REQUIRE_EQUAL(engine.OpenWindows(), 2);
+
+  // Packets in both windows join the earliest one which lacks their channel
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(2, 10900, 1), CoincidenceEngine::kCoincident);
+  BOOST_REQUIRE_EQUAL(engine.ChannelsSeen(10000), 0x5);
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(2, 10950, 1), CoincidenceEngine::kCoincident);
+  BOOST_REQUIRE_EQUAL(engine.ChannelsSeen(10600), 0x5);
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(2, 10980, 1), CoincidenceEngine::kNewTrigger);
+  BOOST_REQUIRE_EQUAL(engine.OpenWindows(), 3);
+
+  // Past the end of the first window only the later ones can be joined
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(3, 11001, 1), CoincidenceEngine::kCoincident);
+  BOOST_REQUIRE_EQUAL(engine.ChannelsSeen(10000), 0x5);
+  BOOST_REQUIRE_EQUAL(engine.ChannelsSeen(10600), 0xD);
+
+  // A dummy trigger opens a window even where a packet would have joined one
+  engine.OpenWindow(4, 10000, 2);
+  BOOST_REQUIRE_EQUAL(engine.OpenWindows(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(OldWindowsExpire)
+{
+  CoincidenceEngine engine(12, 1000);
+
+  engine.AddTrigger(0, 10000, 1);
+  engine.AddTrigger(0, 11500, 1);
+
+  // Nothing can join a window more than two windows behind the latest packet
+  engine.AddTrigger(0, 13200, 1);
+  BOOST_REQUIRE_EQUAL(engine.OpenWindows(), 2);
+  BOOST_REQUIRE_EQUAL(engine.ChannelsSeen(10000), 0);
+  BOOST_REQUIRE_EQUAL(engine.ChannelsSeen(11500), 0x1);
+
+  // Even when that packet arrives late
+  engine.AddTrigger(1, 11900, 1);
+  BOOST_REQUIRE_EQUAL(engine.ChannelsSeen(11500), 0x3);
+
+  engine.Reset();
+  BOOST_REQUIRE_EQUAL(engine.OpenWindows(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ChannelLimits)
+{
+  CoincidenceEngine engine(5, 1000);
+
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(5, 10000, 1), CoincidenceEngine::kBadChannel);
+  BOOST_REQUIRE_EQUAL(engine.OpenWindows(), 0);
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(4, 10000, 1), CoincidenceEngine::kNewTrigger);
+
+  // A dummy trigger on a channel the board does not have sees no channels
+  engine.OpenWindow(7, 20000, 2);
+  BOOST_REQUIRE_EQUAL(engine.ChannelsSeen(20000), 0);
+
+  // The header has room for 16 channels at most
+  engine.SetNChannels(20);
+  BOOST_REQUIRE_EQUAL(engine.NChannels(), 16);
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(16, 20000, 1), CoincidenceEngine::kBadChannel);
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(15, 20000, 1), CoincidenceEngine::kCoincident);
+  BOOST_REQUIRE_EQUAL(engine.ChannelsSeen(20000), 0x8000);
+}
+
+BOOST_AUTO_TEST_CASE(EveryChannelInOneWindow)
+{
+  CoincidenceEngine engine(12, 1000);
+
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(0, 10000, 1), CoincidenceEngine::kNewTrigger);
+  for (unsigned int channel = 1; channel < 12; ++channel) {
+    BOOST_REQUIRE_EQUAL(engine.AddTrigger(channel, 10000 + channel, 1), CoincidenceEngine::kCoincident);
+  }
+  BOOST_REQUIRE_EQUAL(engine.ChannelsSeen(10000), 0xFFF);
+
+  // A full window takes no more packets
+  BOOST_REQUIRE_EQUAL(engine.AddTrigger(6, 10020, 1), CoincidenceEngine::kNewTrigger);
+  BOOST_REQUIRE_EQUAL(engine.OpenWindows(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(DummyTriggers)
+{
+  CoincidenceEngine engine;
+
+  BOOST_REQUIRE(!engine.DummyTriggerDue(5000, 0));
+  BOOST_REQUIRE(engine.DummyTriggerDue(5000, 1000));
+  BOOST_REQUIRE(!engine.DummyTriggerDue(5999, 1000));
+  BOOST_REQUIRE(engine.DummyTriggerDue(6000, 1000));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,140 @@
+/**
+ * @file FragmentBufferPool_test.cxx FragmentBufferPool class Unit Tests
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "anlBoard/FragmentBufferPool.hpp"
+
+#define BOOST_TEST_MODULE FragmentBufferPool_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <utility>
+#include <vector>
+
+using namespace dunedaq::sspmodules;
+
+BOOST_AUTO_TEST_SUITE(FragmentBufferPool_test)
+
+namespace {
+std::vector<unsigned int>
+buffer_of(unsigned int capacity)
+{
+  std::vector<unsigned int> buffer;
+  buffer.reserve(capacity);
+  return buffer;
+}
+} // namespace ""
+
+BOOST_AUTO_TEST_CASE(Acquire)
+{
+  FragmentBufferPool pool(4, 256);
+  std::vector<unsigned int> buffer;
+
+  // Nothing free, so a new buffer of at least the reserve size
+  pool.Acquire(buffer, 100);
+  BOOST_REQUIRE_GE(buffer.capacity(), 256);
+  BOOST_REQUIRE_EQUAL(pool.Misses(), 1);
+  BOOST_REQUIRE_EQUAL(pool.Available(), 0);
+
+  // Big enough already
+  pool.Acquire(buffer, 200);
+  BOOST_REQUIRE_EQUAL(pool.Hits(), 1);
+
+  // Too small: the old storage is kept for someone else
+  pool.Acquire(buffer, 1000);
+  BOOST_REQUIRE_GE(buffer.capacity(), 1000);
+  BOOST_REQUIRE_EQUAL(pool.Misses(), 2);
+  BOOST_REQUIRE_EQUAL(pool.Available(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(ReleaseAndReuse)
+{
+  FragmentBufferPool pool(4, 256);
+
+  std::vector<unsigned int> released = buffer_of(1000);
+  const unsigned int* storage = released.data();
+  pool.Release(std::move(released));
+  BOOST_REQUIRE_EQUAL(pool.Available(), 1);
+
+  // Buffers without storage are not worth keeping
+  pool.Release(std::vector<unsigned int>());
+  BOOST_REQUIRE_EQUAL(pool.Available(), 1);
+
+  std::vector<unsigned int> buffer;
+  pool.Acquire(buffer, 500);
+  BOOST_REQUIRE_EQUAL(pool.Hits(), 1);
+  BOOST_REQUIRE_EQUAL(pool.Misses(), 0);
+  BOOST_REQUIRE(buffer.data() == storage);
+  BOOST_REQUIRE_EQUAL(pool.Available(), 0);
+
+  // A free buffer which is too small is left where it is
+  pool.Release(buffer_of(10));
+  std::vector<unsigned int> other;
+  pool.Acquire(other, 20);
+  BOOST_REQUIRE_EQUAL(pool.Misses(), 1);
+  BOOST_REQUIRE_EQUAL(pool.Available(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(RecycleKeepsTheLargest)
+{
+  FragmentBufferPool pool(2, 16);
+
+  pool.Release(buffer_of(10));
+  pool.Release(buffer_of(20));
+  BOOST_REQUIRE_EQUAL(pool.Available(), 2);
+
+  // Full up: a smaller buffer is dropped, a bigger one replaces the smallest
+  pool.Release(buffer_of(5));
+  pool.Release(buffer_of(100));
+  BOOST_REQUIRE_EQUAL(pool.Available(), 2);
+
+  std::vector<unsigned int> first;
+  pool.Acquire(first, 50);
+  BOOST_REQUIRE_GE(first.capacity(), 100);
+  std::vector<unsigned int> second;
+  pool.Acquire(second, 15);
+  BOOST_REQUIRE_EQUAL(pool.Hits(), 2);
+  BOOST_REQUIRE_EQUAL(pool.Available(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Reserve)
+{
+  FragmentBufferPool pool(3, 64);
+
+  pool.Reserve(2);
+  BOOST_REQUIRE_EQUAL(pool.Available(), 2);
+  pool.Reserve(10);
+  BOOST_REQUIRE_EQUAL(pool.Available(), 3);
+
+  std::vector<unsigned int> buffer;
+  pool.Acquire(buffer, 64);
+  BOOST_REQUIRE_EQUAL(pool.Hits(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(TypicalWords)
+{
+  FragmentBufferPool pool(4, 256);
+  BOOST_REQUIRE_EQUAL(pool.TypicalWords(), 256);
+
+  // Once enough sizes have been seen, new buffers fit nearly all of them
+  for (unsigned int i = 0; i < 100; ++i) {
+    std::vector<unsigned int> buffer;
+    pool.Acquire(buffer, i == 0 ? 100000 : 1000);
+  }
+  BOOST_REQUIRE_EQUAL(pool.TypicalWords(), 1024);
+
+  FragmentBufferPool fresh(4, 256);
+  for (unsigned int i = 0; i < 100; ++i) {
+    std::vector<unsigned int> buffer;
+    fresh.Acquire(buffer, 1000);
+  }
+  std::vector<unsigned int> buffer;
+  fresh.Acquire(buffer, 10);
+  BOOST_REQUIRE_GE(buffer.capacity(), 1024);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
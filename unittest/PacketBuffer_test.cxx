@@ -0,0 +1,219 @@
+/**
+ * @file PacketBuffer_test.cxx PacketBuffer class Unit Tests
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "anlBoard/PacketBuffer.hpp"
+
+#define BOOST_TEST_MODULE PacketBuffer_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <utility>
+#include <vector>
+
+using namespace dunedaq::sspmodules;
+
+BOOST_AUTO_TEST_SUITE(PacketBuffer_test)
+
+namespace {
+// A packet whose payload is nWords copies of time, so it can be recognised later
+EventPacket
+make_packet(unsigned long time, unsigned int nWords = 4) // NOLINT(runtime/int)
+{
+  EventPacket packet;
+  packet.data.assign(nWords, static_cast<unsigned int>(time));
+  return packet;
+}
+
+void
+push(PacketBuffer& buffer, unsigned long time, unsigned int nWords = 4) // NOLINT(runtime/int)
+{
+  buffer.Push(make_packet(time, nWords), time);
+}
+
+// Timestamps in buffer order, checking that each packet is still with its own
+std::vector<unsigned long> // NOLINT(runtime/int)
+times(const PacketBuffer& buffer)
+{
+  std::vector<unsigned long> result; // NOLINT(runtime/int)
+  for (unsigned int i = 0; i < buffer.Size(); ++i) {
+    BOOST_REQUIRE_EQUAL(buffer.At(i).data.front(), buffer.TimeAt(i));
+    result.push_back(buffer.TimeAt(i));
+  }
+  return result;
+}
+} // namespace ""
+
+BOOST_AUTO_TEST_CASE(OutOfOrderPush)
+{
+  PacketBuffer buffer(8);
+
+  push(buffer, 100);
+  push(buffer, 200);
+  push(buffer, 400);
+  push(buffer, 300);
+  push(buffer, 50);
+  push(buffer, 400);
+
+  std::vector<unsigned long> expected = { 50, 100, 200, 300, 400, 400 }; // NOLINT(runtime/int)
+  std::vector<unsigned long> found = times(buffer);                      // NOLINT(runtime/int)
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(found.begin(), found.end(), expected.begin(), expected.end());
+  BOOST_REQUIRE_EQUAL(buffer.Size(), 6);
+  BOOST_REQUIRE_EQUAL(buffer.LatestTime(), 400);
+}
+
+BOOST_AUTO_TEST_CASE(GrowWhileWrapped)
+{
+  PacketBuffer buffer(4);
+
+  // Move the start of the ring along so the packets wrap round its end
+  for (unsigned long time = 10; time <= 40; time += 10) { // NOLINT(runtime/int)
+    push(buffer, time);
+  }
+  BOOST_REQUIRE_EQUAL(buffer.ReleaseBefore(30), 2);
+  push(buffer, 50);
+  push(buffer, 60);
+
+  // Full, so this one grows the ring as well as going back past two packets
+  push(buffer, 45);
+  push(buffer, 70);
+
+  std::vector<unsigned long> expected = { 30, 40, 45, 50, 60, 70 }; // NOLINT(runtime/int)
+  std::vector<unsigned long> found = times(buffer);                 // NOLINT(runtime/int)
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(found.begin(), found.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(Window)
+{
+  PacketBuffer buffer;
+  for (unsigned long time = 100; time <= 500; time += 100) { // NOLINT(runtime/int)
+    push(buffer, time);
+  }
+
+  // Start inclusive, end exclusive
+  BOOST_REQUIRE(buffer.Window(200, 400) == std::make_pair(1u, 3u));
+  BOOST_REQUIRE(buffer.Window(150, 401) == std::make_pair(1u, 4u));
+  BOOST_REQUIRE(buffer.Window(0, 100) == std::make_pair(0u, 0u));
+  BOOST_REQUIRE(buffer.Window(500, 1000) == std::make_pair(4u, 5u));
+  BOOST_REQUIRE(buffer.Window(600, 1000) == std::make_pair(5u, 5u));
+
+  // An empty or backwards window holds nothing
+  BOOST_REQUIRE(buffer.Window(300, 300) == std::make_pair(2u, 2u));
+  BOOST_REQUIRE(buffer.Window(300, 200) == std::make_pair(2u, 2u));
+
+  PacketBuffer empty;
+  BOOST_REQUIRE(empty.Window(0, 1000) == std::make_pair(0u, 0u));
+}
+
+BOOST_AUTO_TEST_CASE(ReleaseBefore)
+{
+  PacketBuffer buffer;
+  unsigned long emptyFootprint = buffer.Footprint(); // NOLINT(runtime/int)
+  for (unsigned long time = 100; time <= 500; time += 100) { // NOLINT(runtime/int)
+    push(buffer, time);
+  }
+  unsigned long fullFootprint = buffer.Footprint(); // NOLINT(runtime/int)
+  BOOST_REQUIRE_GT(fullFootprint, emptyFootprint);
+
+  BOOST_REQUIRE_EQUAL(buffer.ReleaseBefore(100), 0);
+  BOOST_REQUIRE_EQUAL(buffer.ReleaseBefore(250), 2);
+  BOOST_REQUIRE_EQUAL(buffer.Size(), 3);
+  BOOST_REQUIRE_EQUAL(buffer.TimeAt(0), 300);
+  BOOST_REQUIRE_LT(buffer.Footprint(), fullFootprint);
+
+  // Released packets are not counted as evicted
+  BOOST_REQUIRE_EQUAL(buffer.EvictedPackets(), 0);
+  BOOST_REQUIRE_EQUAL(buffer.HighWaterFootprint(), fullFootprint);
+
+  BOOST_REQUIRE_EQUAL(buffer.ReleaseBefore(1000), 3);
+  BOOST_REQUIRE(buffer.Empty());
+  BOOST_REQUIRE_EQUAL(buffer.Footprint(), emptyFootprint);
+
+  push(buffer, 600);
+  buffer.Clear();
+  BOOST_REQUIRE(buffer.Empty());
+  BOOST_REQUIRE_EQUAL(buffer.Footprint(), emptyFootprint);
+}
+
+BOOST_AUTO_TEST_CASE(EvictBySpan)
+{
+  PacketBuffer buffer;
+  buffer.SetLimits(0, 100);
+
+  for (unsigned long time = 1000; time <= 1500; time += 50) { // NOLINT(runtime/int)
+    push(buffer, time);
+  }
+
+  // Packets more than 100 ticks older than the newest are gone
+  std::vector<unsigned long> expected = { 1400, 1450, 1500 }; // NOLINT(runtime/int)
+  std::vector<unsigned long> found = times(buffer);           // NOLINT(runtime/int)
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(found.begin(), found.end(), expected.begin(), expected.end());
+  BOOST_REQUIRE_EQUAL(buffer.EvictedPackets(), 8);
+  BOOST_REQUIRE_EQUAL(buffer.EvictedBytes(), 8 * 4 * sizeof(unsigned int));
+
+  // A late packet older than the span is evicted straight away
+  push(buffer, 1300);
+  BOOST_REQUIRE_EQUAL(buffer.TimeAt(0), 1400);
+  BOOST_REQUIRE_EQUAL(buffer.EvictedPackets(), 9);
+
+  // Tightening the limit applies to what is already held
+  buffer.SetLimits(0, 60);
+  BOOST_REQUIRE_EQUAL(buffer.Size(), 2);
+  BOOST_REQUIRE_EQUAL(buffer.TimeAt(0), 1450);
+
+  buffer.ResetStats();
+  BOOST_REQUIRE_EQUAL(buffer.EvictedPackets(), 0);
+  BOOST_REQUIRE_EQUAL(buffer.EvictedBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(EvictByBytes)
+{
+  PacketBuffer buffer;
+  unsigned long emptyFootprint = buffer.Footprint();            // NOLINT(runtime/int)
+  const unsigned long packetBytes = 100 * sizeof(unsigned int); // NOLINT(runtime/int)
+
+  // Room for the ring and two packets
+  const unsigned long limit = emptyFootprint + 2 * packetBytes + packetBytes / 2; // NOLINT(runtime/int)
+  buffer.SetLimits(limit, 0);
+
+  for (unsigned long time = 100; time <= 500; time += 100) { // NOLINT(runtime/int)
+    push(buffer, time, 100);
+    BOOST_REQUIRE_LE(buffer.Footprint(), limit);
+  }
+  std::vector<unsigned long> expected = { 400, 500 }; // NOLINT(runtime/int)
+  std::vector<unsigned long> found = times(buffer);   // NOLINT(runtime/int)
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(found.begin(), found.end(), expected.begin(), expected.end());
+  BOOST_REQUIRE_EQUAL(buffer.EvictedPackets(), 3);
+  BOOST_REQUIRE_EQUAL(buffer.EvictedBytes(), 3 * packetBytes);
+  BOOST_REQUIRE_LE(buffer.HighWaterFootprint(), limit);
+
+  // The newest packet is kept even when it is over the limit by itself
+  push(buffer, 600, 1000);
+  BOOST_REQUIRE_EQUAL(buffer.Size(), 1);
+  BOOST_REQUIRE_EQUAL(buffer.TimeAt(0), 600);
+  BOOST_REQUIRE_EQUAL(buffer.EvictedPackets(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(EvictInsteadOfGrowing)
+{
+  PacketBuffer buffer(2);
+  unsigned long ringBytes = buffer.Footprint(); // NOLINT(runtime/int)
+
+  // Doubling the ring would break the limit, so a full ring makes room instead
+  buffer.SetLimits(ringBytes + ringBytes / 2, 0);
+  push(buffer, 100, 1);
+  push(buffer, 200, 1);
+  push(buffer, 300, 1);
+
+  std::vector<unsigned long> expected = { 200, 300 }; // NOLINT(runtime/int)
+  std::vector<unsigned long> found = times(buffer);   // NOLINT(runtime/int)
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(found.begin(), found.end(), expected.begin(), expected.end());
+  BOOST_REQUIRE_EQUAL(buffer.EvictedPackets(), 1);
+  BOOST_REQUIRE_LE(buffer.Footprint(), ringBytes + ringBytes / 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,114 @@
+/**
+ * @file RegisterCache_test.cxx RegisterCache class Unit Tests
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "anlBoard/RegisterCache.hpp"
+
+#define BOOST_TEST_MODULE RegisterCache_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+using namespace dunedaq::sspmodules;
+
+BOOST_AUTO_TEST_SUITE(RegisterCache_test)
+
+namespace {
+// Configuration-only registers, see RegMap
+const unsigned int kTriggerInputDelay = 0x80000400; // read/write mask 0x0000FFFF
+const unsigned int kPdtsCmdDelay1 = 0x80000944;     // element [1] of pdts_cmd_delay
+// Registers the board changes, or which act on every write
+const unsigned int kPdtsStatus = 0x800004C4;
+const unsigned int kPdtsCmdControl2 = 0x80000468; // element [2] takes the command strobe
+} // namespace ""
+
+BOOST_AUTO_TEST_CASE(OnlyConfigOnlyRegistersAreCached)
+{
+  RegisterCache cache;
+
+  BOOST_REQUIRE(cache.Cacheable(kTriggerInputDelay));
+  BOOST_REQUIRE(cache.Cacheable(kPdtsCmdDelay1));
+  BOOST_REQUIRE(!cache.Cacheable(kPdtsStatus));
+  BOOST_REQUIRE(!cache.Cacheable(kPdtsCmdControl2));
+
+  cache.Store(kPdtsStatus, 0x1);
+  cache.Store(kPdtsCmdControl2, 0x80000000);
+  BOOST_REQUIRE(!cache.Known(kPdtsStatus));
+  BOOST_REQUIRE(!cache.Known(kPdtsCmdControl2));
+  BOOST_REQUIRE(!cache.Unchanged(kPdtsCmdControl2, 0x80000000));
+
+  unsigned int value = 0;
+  BOOST_REQUIRE(!cache.Lookup(kPdtsStatus, value));
+  BOOST_REQUIRE_EQUAL(cache.CachedReads(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(StoreAndLookup)
+{
+  RegisterCache cache;
+  unsigned int value = 0;
+
+  BOOST_REQUIRE(!cache.Lookup(kTriggerInputDelay, value));
+
+  cache.Store(kTriggerInputDelay, 0xABCD1234);
+  BOOST_REQUIRE(cache.Known(kTriggerInputDelay));
+  BOOST_REQUIRE(cache.Lookup(kTriggerInputDelay, value));
+  BOOST_REQUIRE_EQUAL(value, 0x1234); // Only the readable bits come back
+  BOOST_REQUIRE_EQUAL(cache.CachedReads(), 1);
+
+  // Bits outside the write mask do not count as a change
+  BOOST_REQUIRE(cache.Unchanged(kTriggerInputDelay, 0x00001234));
+  BOOST_REQUIRE(!cache.Unchanged(kTriggerInputDelay, 0x00001235));
+  BOOST_REQUIRE(cache.Unchanged(kTriggerInputDelay, 0x00001235, 0x0000FFF0));
+}
+
+BOOST_AUTO_TEST_CASE(StoreMasked)
+{
+  RegisterCache cache;
+  unsigned int value = 0;
+
+  // A partial write to an unknown register leaves it unknown
+  cache.StoreMasked(kPdtsCmdDelay1, 0x000000FF, 0x12);
+  BOOST_REQUIRE(!cache.Known(kPdtsCmdDelay1));
+
+  // One covering every writable bit makes it known
+  cache.StoreMasked(kPdtsCmdDelay1, 0xFFFFFFFF, 0x00001200);
+  BOOST_REQUIRE(cache.Lookup(kPdtsCmdDelay1, value));
+  BOOST_REQUIRE_EQUAL(value, 0x00001200);
+
+  // Once known, partial writes are merged in
+  cache.StoreMasked(kPdtsCmdDelay1, 0x000000FF, 0xFFFFFF34);
+  BOOST_REQUIRE(cache.Lookup(kPdtsCmdDelay1, value));
+  BOOST_REQUIRE_EQUAL(value, 0x00001234);
+
+  cache.StoreMasked(kPdtsStatus, 0xFFFFFFFF, 0x1);
+  BOOST_REQUIRE(!cache.Known(kPdtsStatus));
+}
+
+BOOST_AUTO_TEST_CASE(InvalidateAndClear)
+{
+  RegisterCache cache;
+  unsigned int value = 0;
+
+  cache.Store(kTriggerInputDelay, 0x10);
+  cache.Store(kPdtsCmdDelay1, 0x20);
+
+  cache.Invalidate(kTriggerInputDelay);
+  BOOST_REQUIRE(!cache.Known(kTriggerInputDelay));
+  BOOST_REQUIRE(!cache.Lookup(kTriggerInputDelay, value));
+  BOOST_REQUIRE(!cache.Unchanged(kTriggerInputDelay, 0x10));
+  BOOST_REQUIRE(cache.Known(kPdtsCmdDelay1));
+
+  cache.Clear();
+  BOOST_REQUIRE(!cache.Known(kPdtsCmdDelay1));
+  BOOST_REQUIRE(!cache.Lookup(kPdtsCmdDelay1, value));
+
+  // Statistics are kept across Clear
+  cache.CountSkippedWrites(2);
+  cache.Clear();
+  BOOST_REQUIRE_EQUAL(cache.SkippedWrites(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
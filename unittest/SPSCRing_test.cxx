@@ -0,0 +1,134 @@
+/**
+ * @file SPSCRing_test.cxx SPSCRing class Unit Tests
+ *
+ * This is part of the DUNE DAQ , copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "anlBoard/SPSCRing.hpp"
+
+#define BOOST_TEST_MODULE SPSCRing_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::sspmodules;
+
+BOOST_AUTO_TEST_SUITE(SPSCRing_test)
+
+BOOST_AUTO_TEST_CASE(Empty)
+{
+  SPSCRing<int> ring(4);
+
+  BOOST_REQUIRE_EQUAL(ring.capacity(), 4);
+  BOOST_REQUIRE(ring.empty());
+  BOOST_REQUIRE_EQUAL(ring.size(), 0);
+  BOOST_REQUIRE(ring.read_slot() == nullptr);
+
+  *ring.write_slot() = 1;
+  BOOST_REQUIRE(ring.empty()); // Not visible until committed
+  ring.commit_write();
+  BOOST_REQUIRE(!ring.empty());
+
+  BOOST_REQUIRE_EQUAL(*ring.read_slot(), 1);
+  ring.commit_read();
+  BOOST_REQUIRE(ring.empty());
+  BOOST_REQUIRE(ring.read_slot() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(Full)
+{
+  SPSCRing<int> ring(3);
+
+  for (int i = 0; i < 3; ++i) {
+    int* slot = ring.write_slot();
+    BOOST_REQUIRE(slot != nullptr);
+    *slot = i;
+    ring.commit_write();
+  }
+  BOOST_REQUIRE_EQUAL(ring.size(), 3);
+  BOOST_REQUIRE(ring.write_slot() == nullptr);
+  ring.record_overrun();
+  BOOST_REQUIRE_EQUAL(ring.overruns(), 1);
+  BOOST_REQUIRE_EQUAL(ring.high_water(), 3);
+
+  // Draining one element frees one slot
+  BOOST_REQUIRE_EQUAL(*ring.read_slot(), 0);
+  ring.commit_read();
+  BOOST_REQUIRE(ring.write_slot() != nullptr);
+
+  ring.reset_stats();
+  BOOST_REQUIRE_EQUAL(ring.overruns(), 0);
+  BOOST_REQUIRE_EQUAL(ring.high_water(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Wrap)
+{
+  SPSCRing<int> ring(3);
+  int written = 0;
+  int read = 0;
+
+  // Keep two elements in flight so the positions pass the end of the buffer several times
+  for (int round = 0; round < 10; ++round) {
+    while (ring.size() < 2) {
+      *ring.write_slot() = written++;
+      ring.commit_write();
+    }
+    BOOST_REQUIRE_EQUAL(*ring.read_slot(), read++);
+    ring.commit_read();
+    BOOST_REQUIRE_EQUAL(ring.size(), 1);
+  }
+  BOOST_REQUIRE_EQUAL(*ring.read_slot(), read);
+  BOOST_REQUIRE_EQUAL(ring.high_water(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(ElementsAreReused)
+{
+  SPSCRing<std::vector<int>> ring(1);
+
+  std::vector<int>* slot = ring.write_slot();
+  slot->assign(100, 1);
+  ring.commit_write();
+  ring.read_slot()->clear();
+  ring.commit_read();
+
+  // The ring holds capacity+1 elements, so come round to the first one again
+  ring.commit_write();
+  ring.commit_read();
+  BOOST_REQUIRE_GE(ring.write_slot()->capacity(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(OneProducerOneConsumer)
+{
+  SPSCRing<int> ring(16);
+  const int n = 100000;
+
+  std::thread producer([&ring]() {
+    for (int i = 0; i < n; ++i) {
+      int* slot;
+      while ((slot = ring.write_slot()) == nullptr)
+        std::this_thread::yield();
+      *slot = i;
+      ring.commit_write();
+    }
+  });
+
+  bool inOrder = true;
+  for (int i = 0; i < n; ++i) {
+    int* slot;
+    while ((slot = ring.read_slot()) == nullptr)
+      std::this_thread::yield();
+    inOrder = inOrder && *slot == i;
+    ring.commit_read();
+  }
+  producer.join();
+
+  BOOST_REQUIRE(inOrder);
+  BOOST_REQUIRE(ring.empty());
+  BOOST_REQUIRE_LE(ring.high_water(), 16);
+}
+
+BOOST_AUTO_TEST_SUITE_END()